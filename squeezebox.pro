@@ -1,6 +1,6 @@
 TEMPLATE  = lib
 CONFIG   += plugin
-QT       += core quick network
+QT       += core quick network concurrent
 
 # Plugin VERSION
 GIT_HASH = "$$system(git log -1 --format="%H")"
@@ -56,8 +56,34 @@ unix {
 QMAKE_SUBSTITUTES += squeezebox.json.in version.txt.in
 # output path must be included for the output file from QMAKE_SUBSTITUTES
 INCLUDEPATH += $$OUT_PWD
-HEADERS  += src/squeezebox.h
-SOURCES  += src/squeezebox.cpp
+HEADERS  += src/squeezebox.h \
+            src/browsecache.h \
+            src/cometdscanner.h \
+            src/jsonstreamreader.h \
+            src/latencystats.h \
+            src/libraryindex.h \
+            src/linkdiagnostics.h \
+            src/nowplayingmodel.h \
+            src/placeholdertable.h \
+            src/rttestimator.h \
+            src/statusdecoder.h \
+            src/thumbnailfetcher.h \
+            src/thumbnailprovider.h \
+            src/thumbnailstore.h
+SOURCES  += src/squeezebox.cpp \
+            src/browsecache.cpp \
+            src/cometdscanner.cpp \
+            src/jsonstreamreader.cpp \
+            src/latencystats.cpp \
+            src/libraryindex.cpp \
+            src/linkdiagnostics.cpp \
+            src/nowplayingmodel.cpp \
+            src/placeholdertable.cpp \
+            src/rttestimator.cpp \
+            src/statusdecoder.cpp \
+            src/thumbnailfetcher.cpp \
+            src/thumbnailprovider.cpp \
+            src/thumbnailstore.cpp
 TARGET    = squeezebox
 
 # Configure destination path. DESTDIR is set in qmake-destination-path.pri
@@ -0,0 +1,206 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "browsecache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPair>
+#include <QUrl>
+#include <QVector>
+#include <algorithm>
+
+BrowseCache::BrowseCache(const QString& directory)
+    : _directory(directory), _pageUse(0), _usageChanged(false), _iconBytes(0) {
+    QDir().mkpath(_directory + "/icons");
+    loadUsage();
+
+    // the usage counts are written once after a burst of browsing, not with every page
+    _usageSave.setSingleShot(true);
+    _usageSave.setInterval(30 * 1000);
+    QObject::connect(&_usageSave, &QTimer::timeout, [this]() { saveUsage(); });
+
+    for (const QFileInfo& icon : QDir(_directory + "/icons").entryInfoList(QDir::Files)) {
+        _iconBytes += icon.size();
+    }
+    evictIcons();
+}
+
+BrowseCache::~BrowseCache() { saveUsage(); }
+
+bool BrowseCache::lookup(const QString& key, QVariantMap* page) {
+    auto found = _pages.find(key);
+    if (found == _pages.end()) {
+        return false;
+    }
+    if (found->expires < QDateTime::currentMSecsSinceEpoch()) {
+        _pages.erase(found);
+        return false;
+    }
+    found->lastUsed = ++_pageUse;
+    *page = found->data;
+    return true;
+}
+
+void BrowseCache::insert(const QString& key, const QVariantMap& page, int ttl) {
+    Page entry;
+    entry.data = page;
+    entry.expires = QDateTime::currentMSecsSinceEpoch() + ttl * 1000LL;
+    entry.lastUsed = ++_pageUse;
+    _pages.insert(key, entry);
+    evictPages();
+}
+
+void BrowseCache::evictPages() {
+    if (_pages.size() <= MAX_PAGES) {
+        return;
+    }
+
+    // expired pages go first, then the least recently used ones
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (auto i = _pages.begin(); i != _pages.end();) {
+        if (i->expires < now) {
+            i = _pages.erase(i);
+        } else {
+            ++i;
+        }
+    }
+    if (_pages.size() <= MAX_PAGES) {
+        return;
+    }
+
+    QVector<QPair<qint64, QString>> order;
+    order.reserve(_pages.size());
+    for (auto i = _pages.constBegin(); i != _pages.constEnd(); ++i) {
+        order.append(qMakePair(i->lastUsed, i.key()));
+    }
+    std::sort(order.begin(), order.end());
+    for (int i = 0; i < order.size() && _pages.size() > MAX_PAGES * 9 / 10; ++i) {
+        _pages.remove(order.at(i).second);
+    }
+}
+
+void BrowseCache::clear() { _pages.clear(); }
+
+void BrowseCache::countUse(const QString& menu) {
+    _usage[menu]++;
+    _usageChanged = true;
+    if (!_usageSave.isActive()) {
+        _usageSave.start();
+    }
+}
+
+QStringList BrowseCache::mostUsed(int count) const {
+    QStringList menus = _usage.keys();
+    std::sort(menus.begin(), menus.end(),
+              [this](const QString& a, const QString& b) { return _usage.value(a) > _usage.value(b); });
+    return menus.mid(0, count);
+}
+
+QString BrowseCache::iconFile(const QString& url) const {
+    QString hash = QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Sha1).toHex();
+    QString suffix = QFileInfo(QUrl(url).path()).suffix();
+    return _directory + "/icons/" + hash + (suffix.isEmpty() ? "" : "." + suffix);
+}
+
+QString BrowseCache::cachedIcon(const QString& url) const {
+    QString file = iconFile(url);
+    if (!QFile::exists(file)) {
+        return QString();
+    }
+    return QUrl::fromLocalFile(file).toString();
+}
+
+bool BrowseCache::storeIcon(const QString& url, const QByteArray& data) {
+    // an icon stored again replaces the old file, which must not count twice
+    QFile  file(iconFile(url));
+    qint64 previous = file.exists() ? file.size() : 0;
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    _iconBytes -= previous;
+    if (file.write(data) != data.size()) {
+        file.remove();  // a partial icon would show up broken
+        return false;
+    }
+    file.close();
+
+    _iconBytes += data.size();
+    evictIcons();
+    return true;
+}
+
+void BrowseCache::evictIcons() {
+    if (_iconBytes <= MAX_ICON_BYTES) {
+        return;
+    }
+
+    // oldest first, down to 80% so the directory is not listed for every new icon
+    QFileInfoList icons = QDir(_directory + "/icons").entryInfoList(QDir::Files, QDir::Time | QDir::Reversed);
+    _iconBytes = 0;
+    for (const QFileInfo& icon : icons) {
+        _iconBytes += icon.size();
+    }
+    for (const QFileInfo& icon : icons) {
+        if (_iconBytes <= MAX_ICON_BYTES * 8 / 10) {
+            break;
+        }
+        if (QFile::remove(icon.filePath())) {
+            _iconBytes -= icon.size();
+        }
+    }
+}
+
+void BrowseCache::loadUsage() {
+    QFile file(_directory + "/browse_usage.json");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QVariantMap usage = QJsonDocument::fromJson(file.readAll()).object().toVariantMap();
+    for (auto i = usage.constBegin(); i != usage.constEnd(); ++i) {
+        _usage.insert(i.key(), i.value().toInt());
+    }
+}
+
+void BrowseCache::saveUsage() {
+    if (!_usageChanged) {
+        return;
+    }
+    _usageChanged = false;
+
+    QFile file(_directory + "/browse_usage.json");
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QJsonObject usage;
+    for (auto i = _usage.constBegin(); i != _usage.constEnd(); ++i) {
+        usage.insert(i.key(), i.value());
+    }
+    file.write(QJsonDocument(usage).toJson(QJsonDocument::Compact));
+}
@@ -0,0 +1,73 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVariantMap>
+
+// Cache of browse menu pages with a time to live, usage counts of the menus and icons stored on disk.
+// Both caches are bounded: the least recently used pages and the oldest icons are dropped first.
+class BrowseCache {
+ public:
+    static const int    MAX_PAGES = 200;
+    static const int    SERVICE_TTL = 3600;  // seconds, the lists of radio and app services change rarely
+    static const int    ITEM_TTL = 600;      // seconds, the content of radio directories changes more often
+    static const qint64 MAX_ICON_BYTES = 20 * 1024 * 1024;
+
+    explicit BrowseCache(const QString& directory);
+    ~BrowseCache();
+
+    bool lookup(const QString& key, QVariantMap* page);  // fresh pages only
+    void insert(const QString& key, const QVariantMap& page, int ttl);
+    void clear();
+
+    void        countUse(const QString& menu);
+    QStringList mostUsed(int count) const;
+
+    QString iconFile(const QString& url) const;    // where the icon of url is stored
+    QString cachedIcon(const QString& url) const;  // local url of the icon, empty if it is not stored yet
+    bool    storeIcon(const QString& url, const QByteArray& data);
+
+ private:
+    struct Page {
+        QVariantMap data;
+        qint64      expires = 0;  // msecs since epoch
+        qint64      lastUsed = 0;
+    };
+
+    void loadUsage();
+    void saveUsage();
+    void evictPages();
+    void evictIcons();
+
+    QString              _directory;
+    QHash<QString, Page> _pages;  // key: menu, item id and range
+    qint64               _pageUse;
+    QHash<QString, int>  _usage;  // key: menu, value: times opened
+    bool                 _usageChanged;
+    QTimer               _usageSave;
+    qint64               _iconBytes;
+};
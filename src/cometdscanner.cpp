@@ -0,0 +1,213 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "cometdscanner.h"
+
+#include <QtAlgorithms>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+struct ScanState {
+    bool          inString = false;
+    int           escaped = -1;
+    int           depth = 0;
+    int           stringBegin = 0;
+    int           stringEnd = 0;
+    int           keyBegin = 0;
+    int           keyEnd = 0;
+    int           valueBegin = -1;
+    bool          inMessage = false;  // current was opened by a brace at depth 2
+    CometdMessage current;
+};
+
+inline bool isStructural(char c) {
+    return c == '"' || c == '\\' || c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',';
+}
+
+// bit i is set if byte i of the 16 bytes at data is a structural character
+inline quint32 structuralMask(const char* data) {
+#if defined(__SSE2__)
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    __m128i mask = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('{')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('}')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('[')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(']')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(',')));
+    return static_cast<quint32>(_mm_movemask_epi8(mask));
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t           chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(data));
+    uint8x16_t           mask = vceqq_u8(chunk, vdupq_n_u8('"'));
+    mask = vorrq_u8(mask, vceqq_u8(chunk, vdupq_n_u8('\\')));
+    mask = vorrq_u8(mask, vceqq_u8(chunk, vdupq_n_u8('{')));
+    mask = vorrq_u8(mask, vceqq_u8(chunk, vdupq_n_u8('}')));
+    mask = vorrq_u8(mask, vceqq_u8(chunk, vdupq_n_u8('[')));
+    mask = vorrq_u8(mask, vceqq_u8(chunk, vdupq_n_u8(']')));
+    mask = vorrq_u8(mask, vceqq_u8(chunk, vdupq_n_u8(':')));
+    mask = vorrq_u8(mask, vceqq_u8(chunk, vdupq_n_u8(',')));
+
+    // there is no movemask on NEON: weight the bytes and add them up per half
+    uint8x16_t bits = vandq_u8(mask, vld1q_u8(weights));
+    uint8x8_t  sum = vpadd_u8(vget_low_u8(bits), vget_high_u8(bits));
+    sum = vpadd_u8(sum, sum);
+    sum = vpadd_u8(sum, sum);
+    return static_cast<quint32>(vget_lane_u8(sum, 0)) | (static_cast<quint32>(vget_lane_u8(sum, 1)) << 8);
+#else
+    quint32 mask = 0;
+    for (int i = 0; i < 16; ++i) {
+        if (isStructural(data[i])) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+void takeValue(const QByteArray& batch, ScanState* state, int end) {
+    if (state->valueBegin < 0) {
+        return;
+    }
+
+    const char* data = batch.constData();
+    int         keyLength = state->keyEnd - state->keyBegin;
+    bool        channel = keyLength == 7 && qstrncmp(data + state->keyBegin, "channel", 7) == 0;
+    bool        id = keyLength == 2 && qstrncmp(data + state->keyBegin, "id", 2) == 0;
+
+    if (channel || id) {
+        QByteArray value = batch.mid(state->valueBegin, end - state->valueBegin).trimmed();
+        if (value.size() >= 2 && value.startsWith('"') && value.endsWith('"')) {
+            value = value.mid(1, value.size() - 2);
+        }
+        if (channel) {
+            state->current.channel = value;
+        } else {
+            state->current.id = value;
+        }
+    }
+    state->valueBegin = -1;
+}
+
+void process(const QByteArray& batch, int pos, ScanState* state, QVector<CometdMessage>* messages) {
+    if (pos == state->escaped) {
+        return;
+    }
+
+    char c = batch.at(pos);
+    if (state->inString) {
+        if (c == '\\') {
+            state->escaped = pos + 1;
+        } else if (c == '"') {
+            state->inString = false;
+            state->stringEnd = pos;
+        }
+        return;
+    }
+
+    switch (c) {
+        case '"':
+            state->inString = true;
+            state->stringBegin = pos + 1;
+            break;
+        case '{':
+        case '[':
+            if (++state->depth == 2 && c == '{') {
+                state->current = CometdMessage();
+                state->current.begin = pos;
+                state->valueBegin = -1;
+                state->inMessage = true;
+            }
+            break;
+        case ':':
+            if (state->depth == 2) {
+                state->keyBegin = state->stringBegin;
+                state->keyEnd = state->stringEnd;
+                state->valueBegin = pos + 1;
+            }
+            break;
+        case ',':
+            if (state->depth == 2) {
+                takeValue(batch, state, pos);
+            }
+            break;
+        case '}':
+        case ']':
+            // a mismatched bracket drops the message, otherwise the boundaries of malformed input could overlap
+            if (state->depth == 2) {
+                if (c == '}' && state->inMessage) {
+                    takeValue(batch, state, pos);
+                    state->current.end = pos + 1;
+                    messages->append(state->current);
+                }
+                state->inMessage = false;
+            }
+            state->depth--;
+            break;
+    }
+}
+
+}  // namespace
+
+QVector<CometdMessage> CometdScanner::scan(const QByteArray& batch) {
+    QVector<CometdMessage> messages;
+    ScanState              state;
+    const char*            data = batch.constData();
+    int                    size = batch.size();
+    int                    pos = 0;
+
+    for (; pos + 16 <= size; pos += 16) {
+        quint32 mask = structuralMask(data + pos);
+        while (mask != 0) {
+            process(batch, pos + static_cast<int>(qCountTrailingZeroBits(mask)), &state, &messages);
+            mask &= mask - 1;
+        }
+    }
+    for (; pos < size; ++pos) {
+        if (isStructural(data[pos])) {
+            process(batch, pos, &state, &messages);
+        }
+    }
+
+    return messages;
+}
+
+QVector<CometdMessage> CometdScanner::scanScalar(const QByteArray& batch) {
+    QVector<CometdMessage> messages;
+    ScanState              state;
+    const char*            data = batch.constData();
+
+    for (int pos = 0; pos < batch.size(); ++pos) {
+        if (isStructural(data[pos])) {
+            process(batch, pos, &state, &messages);
+        }
+    }
+
+    return messages;
+}
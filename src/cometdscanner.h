@@ -0,0 +1,45 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QVector>
+
+struct CometdMessage {
+    int        begin = 0;  // offset of the opening brace of the message
+    int        end = 0;    // offset behind the closing brace
+    QByteArray channel;
+    QByteArray id;
+};
+
+// Structural pass over a CometD message array.
+// Finds the message boundaries together with the "channel" and "id" values without decoding the messages, so only
+// the messages which are really needed get a full JSON parse. Structural characters are located 16 bytes at a time
+// with SSE2 or NEON, other targets use a scalar loop.
+class CometdScanner {
+ public:
+    static QVector<CometdMessage> scan(const QByteArray& batch);
+
+    // same result one byte at a time, the baseline of the benchmark and the fuzz targets
+    static QVector<CometdMessage> scanScalar(const QByteArray& batch);
+};
@@ -0,0 +1,143 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "jsonstreamreader.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+
+JsonStreamReader::JsonStreamReader(const ItemCallback& callback)
+    : _callback(callback),
+      _depth(0),
+      _loopDepth(-1),
+      _itemDepth(0),
+      _itemCount(0),
+      _inString(false),
+      _escape(false),
+      _afterColon(false) {}
+
+void JsonStreamReader::feed(const QByteArray& chunk) {
+    for (char c : chunk) {
+        if (_itemDepth > 0) {
+            // inside of a loop item: only track the nesting until the item is complete
+            _item.append(c);
+            if (_inString) {
+                if (_escape) {
+                    _escape = false;
+                } else if (c == '\\') {
+                    _escape = true;
+                } else if (c == '"') {
+                    _inString = false;
+                }
+            } else if (c == '"') {
+                _inString = true;
+            } else if (c == '{' || c == '[') {
+                _itemDepth++;
+            } else if (c == '}' || c == ']') {
+                if (--_itemDepth == 0) {
+                    emitItem();
+                }
+            }
+            continue;
+        }
+
+        if (_inString) {
+            _rest.append(c);
+            if (_escape) {
+                _escape = false;
+                _string.append(c);
+            } else if (c == '\\') {
+                _escape = true;
+                _string.append(c);
+            } else if (c == '"') {
+                _inString = false;
+            } else {
+                _string.append(c);
+            }
+            continue;
+        }
+
+        if (_loopDepth >= 0 && _depth == _loopDepth) {
+            // between the items of a loop: items and separators are left out of the remainder
+            if (c == '{') {
+                _item = "{";
+                _itemDepth = 1;
+            } else if (c == ']') {
+                _rest.append(c);
+                _depth--;
+                _loopDepth = -1;
+            }
+            continue;
+        }
+
+        _rest.append(c);
+        switch (c) {
+            case '"':
+                _inString = true;
+                _string.clear();
+                break;
+            case ':':
+                _key = QString::fromUtf8(_string);
+                _afterColon = true;
+                continue;
+            case '[':
+                _depth++;
+                if (_afterColon && _loopDepth < 0 && _key.endsWith("_loop")) {
+                    _loopDepth = _depth;
+                    _loop = _key;
+                }
+                break;
+            case '{':
+                _depth++;
+                break;
+            case '}':
+            case ']':
+                _depth--;
+                break;
+            case ' ':
+            case '\t':
+            case '\r':
+            case '\n':
+                continue;
+        }
+        _afterColon = false;
+    }
+}
+
+QVariantMap JsonStreamReader::finish(QJsonParseError* error) {
+    QJsonDocument doc = QJsonDocument::fromJson(_rest, error);
+    _rest.clear();
+    return doc.object().toVariantMap();
+}
+
+void JsonStreamReader::emitItem() {
+    QJsonParseError parseerror;
+    QJsonDocument   doc = QJsonDocument::fromJson(_item, &parseerror);
+    _item.clear();
+
+    if (parseerror.error != QJsonParseError::NoError) {
+        return;
+    }
+
+    _itemCount++;
+    _callback(_loop, doc.object().toVariantMap());
+}
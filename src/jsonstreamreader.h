@@ -0,0 +1,60 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QJsonParseError>
+#include <QString>
+#include <QVariantMap>
+#include <functional>
+
+// Incremental reader for JSON-RPC replies of the Squeezebox server.
+// Items of result loops ("players_loop", "titles_loop", ...) are handed out as soon as they are complete and are
+// dropped afterwards, so only the current item and the small remainder of the document are held in memory.
+class JsonStreamReader {
+ public:
+    typedef std::function<void(const QString& loop, const QVariantMap& item)> ItemCallback;
+
+    explicit JsonStreamReader(const ItemCallback& callback);
+
+    void        feed(const QByteArray& chunk);
+    QVariantMap finish(QJsonParseError* error);  // remainder of the document without the loop items
+    int         itemCount() const { return _itemCount; }
+
+ private:
+    void emitItem();
+
+    ItemCallback _callback;
+    QByteArray   _rest;    // document without loop items
+    QByteArray   _item;    // loop item currently read
+    QByteArray   _string;  // last string outside of loop items
+    QString      _key;     // last object key outside of loop items
+    QString      _loop;    // name of the loop currently read
+    int          _depth;   // nesting depth outside of loop items
+    int          _loopDepth;
+    int          _itemDepth;
+    int          _itemCount;
+    bool         _inString;
+    bool         _escape;
+    bool         _afterColon;
+};
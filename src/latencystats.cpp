@@ -0,0 +1,68 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "latencystats.h"
+
+#include <algorithm>
+
+LatencyStats::LatencyStats(int capacity) : _capacity(capacity), _next(0) { _samples.reserve(capacity); }
+
+void LatencyStats::add(qint64 sample) {
+    if (_samples.size() < _capacity) {
+        _samples.append(sample);
+    } else {
+        _samples[_next] = sample;
+    }
+    _next = (_next + 1) % _capacity;
+}
+
+void LatencyStats::clear() {
+    _samples.clear();
+    _next = 0;
+}
+
+qint64 LatencyStats::percentile(double percent) const {
+    if (_samples.isEmpty()) {
+        return 0;
+    }
+
+    QVector<qint64> sorted = _samples;
+    int             rank = qBound(0, static_cast<int>(percent / 100.0 * sorted.size()), sorted.size() - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted.at(rank);
+}
+
+qint64 LatencyStats::max() const {
+    if (_samples.isEmpty()) {
+        return 0;
+    }
+    return *std::max_element(_samples.constBegin(), _samples.constEnd());
+}
+
+QVariantMap LatencyStats::toMap() const {
+    QVariantMap map;
+    map.insert("count", count());
+    map.insert("p50", percentile(50));
+    map.insert("p99", percentile(99));
+    map.insert("max", max());
+    return map;
+}
@@ -0,0 +1,45 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QVariantMap>
+#include <QVector>
+
+// Sliding window of the latest latency samples. The unit is up to the owner, the statistics are in the same unit.
+class LatencyStats {
+ public:
+    explicit LatencyStats(int capacity = 64);
+
+    void   add(qint64 sample);
+    void   clear();
+    int    count() const { return _samples.size(); }
+    qint64 percentile(double percent) const;
+    qint64 max() const;
+
+    QVariantMap toMap() const;  // count, p50, p99 and max
+
+ private:
+    QVector<qint64> _samples;
+    int             _capacity;
+    int             _next;
+};
@@ -0,0 +1,357 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "libraryindex.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QPair>
+#include <algorithm>
+
+static const quint32 INDEX_VERSION = 1;
+static const int     MAX_PLAYS = 20000;  // tracks in the play table
+
+LibraryIndex::LibraryIndex(const QString& directory)
+    : _file(directory + "/library.bin"), _playsFile(directory + "/library_plays.bin"), _playsChanged(false) {
+    QDir().mkpath(directory);
+    loadPlays();
+    load();
+
+    // the play table is written once after a few tracks, not with every track change
+    _playsSave.setSingleShot(true);
+    _playsSave.setInterval(5 * 60 * 1000);
+    QObject::connect(&_playsSave, &QTimer::timeout, [this]() { savePlays(); });
+}
+
+LibraryIndex::~LibraryIndex() { savePlays(); }
+
+void LibraryIndex::clear() {
+    _scanId.clear();
+    _entries.clear();
+    _ids.clear();
+    _postings.clear();
+}
+
+void LibraryIndex::addTrack(const QVariantMap& track) {
+    QString artist = track.value("artist").toString();
+    addEntry(Track, track.value("id").toString(), track.value("title").toString(), artist);
+
+    // artists and albums are as popular as they have tracks
+    if (!track.value("artist_id").toString().isEmpty() && !artist.isEmpty()) {
+        _entries[addEntry(Artist, track.value("artist_id").toString(), artist, QString())].popularity++;
+    }
+    if (!track.value("album_id").toString().isEmpty() && !track.value("album").toString().isEmpty()) {
+        _entries[addEntry(Album, track.value("album_id").toString(), track.value("album").toString(), artist)]
+            .popularity++;
+    }
+}
+
+void LibraryIndex::finish(const QString& scanId) {
+    _scanId = scanId;
+    _ids.squeeze();
+    _entries.squeeze();
+    buildPostings();
+    applyPlays();
+    save();
+}
+
+int LibraryIndex::addEntry(int type, const QString& id, const QString& name, const QString& artist) {
+    QString key = QString::number(type) + ":" + id;
+    int     index = _ids.value(key, -1);
+    if (index >= 0) {
+        return index;
+    }
+
+    Entry entry;
+    entry.type = type;
+    entry.id = id;
+    entry.name = name;
+    entry.artist = artist;
+    entry.normalized = normalize(name);
+    _entries.append(entry);
+    _ids.insert(key, _entries.size() - 1);
+    return _entries.size() - 1;
+}
+
+void LibraryIndex::countPlay(const QString& trackId) {
+    if (trackId.isEmpty()) {
+        return;
+    }
+    _plays[trackId]++;
+    prunePlays(trackId);
+    _playsChanged = true;
+    if (!_playsSave.isActive()) {
+        _playsSave.start();
+    }
+
+    int index = _ids.value(QString::number(Track) + ":" + trackId, -1);
+    if (index >= 0) {
+        _entries[index].plays++;
+    }
+}
+
+void LibraryIndex::prunePlays(const QString& keep) {
+    if (_plays.size() <= MAX_PLAYS) {
+        return;
+    }
+
+    // down to 90 %, so the table is not sorted with every play. Tracks gone from the library go first, then the
+    // least played ones.
+    QVector<QPair<qint32, QString>> ranked;
+    ranked.reserve(_plays.size());
+    for (auto i = _plays.constBegin(); i != _plays.constEnd(); ++i) {
+        bool known = _ids.contains(QString::number(Track) + ":" + i.key());
+        ranked.append(qMakePair(known || _entries.isEmpty() ? i.value() : 0, i.key()));
+    }
+    std::sort(ranked.begin(), ranked.end());
+    for (const auto& track : ranked) {
+        if (_plays.size() <= MAX_PLAYS * 9 / 10) {
+            break;
+        }
+        if (track.second != keep) {
+            _plays.remove(track.second);
+        }
+    }
+}
+
+void LibraryIndex::applyPlays() {
+    for (auto i = _plays.constBegin(); i != _plays.constEnd(); ++i) {
+        int index = _ids.value(QString::number(Track) + ":" + i.key(), -1);
+        if (index >= 0) {
+            _entries[index].plays = i.value();
+        }
+    }
+}
+
+QVariantList LibraryIndex::search(const QString& query, int limit) const {
+    QVariantList     result;
+    QString          normalized = normalize(query);
+    QVector<quint64> grams = trigrams(normalized);
+    if (grams.isEmpty() || limit <= 0) {
+        return result;
+    }
+
+    // candidates share at least a third of the trigrams of the query, a typo spoils up to three of them
+    QVector<quint16> hits(_entries.size(), 0);
+    QVector<int>     touched;
+    for (quint64 gram : grams) {
+        auto postings = _postings.constFind(gram);
+        if (postings == _postings.constEnd()) {
+            continue;
+        }
+        for (int index : *postings) {
+            if (hits[index]++ == 0) {
+                touched.append(index);
+            }
+        }
+    }
+    int          required = qMax(1, grams.size() / 3);
+    QVector<int> candidates;
+    for (int index : touched) {
+        if (hits.at(index) >= required) {
+            candidates.append(index);
+        }
+    }
+
+    // only the best trigram matches are worth the edit distance
+    int checked = qMax(limit * 10, 100);
+    if (candidates.size() > checked) {
+        std::partial_sort(candidates.begin(), candidates.begin() + checked, candidates.end(),
+                          [&hits](int a, int b) { return hits.at(a) > hits.at(b); });
+        candidates.resize(checked);
+    }
+
+    struct Match {
+        int index;
+        int distance;
+    };
+    QVector<Match> matches;
+    int            tolerance = qMax(1, normalized.size() / 4);
+    for (int index : candidates) {
+        int d = distance(normalized, _entries.at(index).normalized);
+        if (d <= tolerance) {
+            matches.append({index, d});
+        }
+    }
+    std::sort(matches.begin(), matches.end(), [this](const Match& a, const Match& b) {
+        if (a.distance != b.distance) {
+            return a.distance < b.distance;
+        }
+        const Entry& first = _entries.at(a.index);
+        const Entry& second = _entries.at(b.index);
+        if (first.popularity + first.plays != second.popularity + second.plays) {
+            return first.popularity + first.plays > second.popularity + second.plays;
+        }
+        return first.name.size() < second.name.size();
+    });
+
+    static const char* const types[] = {"artist", "album", "track"};
+    for (int i = 0; i < matches.size() && i < limit; ++i) {
+        const Entry& entry = _entries.at(matches.at(i).index);
+        QVariantMap  item;
+        item.insert("type", types[entry.type]);
+        item.insert("id", entry.id);
+        item.insert("name", entry.name);
+        item.insert("artist", entry.artist);
+        item.insert("distance", matches.at(i).distance);
+        item.insert("popularity", entry.popularity + entry.plays);
+        result.append(item);
+    }
+    return result;
+}
+
+QString LibraryIndex::normalize(const QString& text) {
+    // "Beyoncé & Jay-Z" -> "beyonce jay z"
+    QString decomposed = text.normalized(QString::NormalizationForm_KD);
+    QString result;
+    result.reserve(decomposed.size());
+    for (const QChar& c : decomposed) {
+        if (c.isMark()) {
+            continue;
+        }
+        if (c.isLetterOrNumber()) {
+            result.append(c.toLower());
+        } else if (!result.isEmpty() && !result.endsWith(' ')) {
+            result.append(' ');
+        }
+    }
+    return result.trimmed();
+}
+
+QVector<quint64> LibraryIndex::trigrams(const QString& normalized) {
+    QVector<quint64> result;
+    if (normalized.isEmpty()) {
+        return result;
+    }
+
+    // padded, so short words and word starts have trigrams of their own
+    QString padded = "  " + normalized + " ";
+    result.reserve(padded.size() - 2);
+    for (int i = 0; i + 2 < padded.size(); ++i) {
+        result.append(static_cast<quint64>(padded.at(i).unicode()) << 32 |
+                      static_cast<quint64>(padded.at(i + 1).unicode()) << 16 | padded.at(i + 2).unicode());
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+int LibraryIndex::distance(const QString& query, const QString& text) {
+    // edit distance of the query to the best matching part of the text: skipping the start and the end is free
+    QVector<int> previous(text.size() + 1, 0);
+    QVector<int> current(text.size() + 1, 0);
+    for (int i = 1; i <= query.size(); ++i) {
+        current[0] = i;
+        for (int j = 1; j <= text.size(); ++j) {
+            int substitution = previous.at(j - 1) + (query.at(i - 1) == text.at(j - 1) ? 0 : 1);
+            current[j] = qMin(substitution, qMin(previous.at(j), current.at(j - 1)) + 1);
+        }
+        previous.swap(current);
+    }
+    return *std::min_element(previous.constBegin(), previous.constEnd());
+}
+
+void LibraryIndex::buildPostings() {
+    _postings.clear();
+    for (int index = 0; index < _entries.size(); ++index) {
+        for (quint64 gram : trigrams(_entries.at(index).normalized)) {
+            _postings[gram].append(index);
+        }
+    }
+}
+
+void LibraryIndex::load() {
+    QFile file(_file);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    quint32     version = 0;
+    qint32      count = 0;
+    stream >> version >> _scanId >> count;
+    // every entry takes more than a byte, a larger count is a broken file
+    if (version != INDEX_VERSION || stream.status() != QDataStream::Ok || count < 0 || count > file.size()) {
+        clear();
+        return;
+    }
+
+    _entries.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        Entry  entry;
+        qint32 type = 0;
+        stream >> type >> entry.id >> entry.name >> entry.artist >> entry.popularity;
+        if (stream.status() != QDataStream::Ok || type < Artist || type > Track) {
+            clear();
+            return;
+        }
+        entry.type = type;
+        entry.normalized = normalize(entry.name);
+        _ids.insert(QString::number(type) + ":" + entry.id, _entries.size());
+        _entries.append(entry);
+    }
+    buildPostings();
+    applyPlays();
+}
+
+void LibraryIndex::save() const {
+    QFile file(_file);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << INDEX_VERSION << _scanId << static_cast<qint32>(_entries.size());
+    for (const Entry& entry : _entries) {
+        stream << static_cast<qint32>(entry.type) << entry.id << entry.name << entry.artist << entry.popularity;
+    }
+}
+
+void LibraryIndex::loadPlays() {
+    QFile file(_playsFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    quint32     version = 0;
+    stream >> version >> _plays;
+    if (version != INDEX_VERSION || stream.status() != QDataStream::Ok) {
+        _plays.clear();
+    }
+}
+
+void LibraryIndex::savePlays() {
+    if (!_playsChanged) {
+        return;
+    }
+    _playsChanged = false;
+
+    QFile file(_playsFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << INDEX_VERSION << _plays;
+}
@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QTimer>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QVector>
+
+// Local index of the artist, album and track names of the server library for a search which tolerates typos.
+// Candidates are found by shared trigrams and ranked by edit distance, then by popularity. No round trip to the
+// server is needed, the index is stored in the cache directory together with the scan it was built from. Plays
+// counted on the remote are kept in a table of their own, so they survive the rebuilds after a rescan.
+class LibraryIndex {
+ public:
+    explicit LibraryIndex(const QString& directory);
+    ~LibraryIndex();
+
+    // rebuilding: clear(), addTrack() for every item of "titles ... tags:aels", finish()
+    void clear();
+    void addTrack(const QVariantMap& track);
+    void finish(const QString& scanId);
+
+    QString      scanId() const { return _scanId; }
+    int          count() const { return _entries.size(); }
+    QVariantList search(const QString& query, int limit) const;  // best match first
+    void         countPlay(const QString& trackId);
+
+ private:
+    enum Type { Artist, Album, Track };
+
+    struct Entry {
+        int     type = Track;
+        QString id;
+        QString name;
+        QString artist;          // of albums and tracks
+        QString normalized;      // lower case without accents and punctuation
+        int     popularity = 0;  // tracks of artists and albums
+        int     plays = 0;       // of tracks, from the play table
+    };
+
+    static QString          normalize(const QString& text);
+    static QVector<quint64> trigrams(const QString& normalized);
+    static int              distance(const QString& query, const QString& text);
+
+    int  addEntry(int type, const QString& id, const QString& name, const QString& artist);
+    void buildPostings();
+    void applyPlays();
+    void load();
+    void save() const;
+    void loadPlays();
+    void savePlays();
+    void prunePlays(const QString& keep);
+
+    QString                      _file;
+    QString                      _playsFile;
+    QString                      _scanId;
+    QVector<Entry>               _entries;
+    QHash<QString, int>          _ids;       // key: type and id, value: entry
+    QHash<quint64, QVector<int>> _postings;  // key: trigram, value: entries containing it
+    QHash<QString, qint32>       _plays;     // key: track id
+    bool                         _playsChanged;
+    QTimer                       _playsSave;
+};
@@ -0,0 +1,208 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "linkdiagnostics.h"
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkReply>
+#include <QSharedPointer>
+#include <QTcpSocket>
+#include <QTimer>
+
+static const int TCP_SAMPLES = 3;
+static const int RPC_SAMPLES = 10;
+static const int PUSH_SAMPLES = 5;
+static const int PROBE_TIMEOUT = 5 * 1000;
+
+static QByteArray rpcJson(const QStringList& command) {
+    QJsonArray params = QJsonArray();
+    params.append("-");
+    params.append(QJsonArray::fromStringList(command));
+
+    QJsonObject json = QJsonObject();
+    json.insert("method", "slim.request");
+    json.insert("id", 1);
+    json.insert("params", params);
+
+    return QJsonDocument(json).toJson();
+}
+
+LinkDiagnostics::LinkDiagnostics(QNetworkAccessManager* nam, const QString& host, int port,
+                                 const QNetworkRequest& rpcRequest, const PushProbe& pushProbe, QObject* parent)
+    : QObject(parent),
+      _nam(nam),
+      _host(host),
+      _port(port),
+      _rpcRequest(rpcRequest),
+      _pushProbe(pushProbe),
+      _step(Done),
+      _samples(0) {}
+
+void LinkDiagnostics::start() {
+    if (_step != Done) {
+        return;  // a run is in progress, its report is delivered with finished()
+    }
+    _report.clear();
+    _report.insert("started", QDateTime::currentDateTime().toString(Qt::ISODate));
+    _report.insert("server", _host + ":" + QString::number(_port));
+    _step = TcpConnect;
+    _samples = 0;
+    _latency.clear();
+    probeTcpConnect();
+}
+
+void LinkDiagnostics::next() {
+    // the samples of a step are taken one after the other, so they don't compete with each other
+    switch (_step) {
+        case TcpConnect:
+            if (++_samples < TCP_SAMPLES) {
+                probeTcpConnect();
+                return;
+            }
+            _report.insert("tcpConnectMs", _latency.toMap());
+            _step = RpcRoundTrip;
+            _samples = 0;
+            _latency.clear();
+            probeRpc();
+            return;
+        case RpcRoundTrip:
+            if (++_samples < RPC_SAMPLES) {
+                probeRpc();
+                return;
+            }
+            _report.insert("rpcRoundTripMs", _latency.toMap());
+            _step = PushRoundTrip;
+            _samples = 0;
+            _latency.clear();
+            probePush();
+            return;
+        case PushRoundTrip:
+            if (++_samples < PUSH_SAMPLES) {
+                probePush();
+                return;
+            }
+            _report.insert("pushRoundTripMs", _latency.toMap());
+            _step = Throughput;
+            probeThroughput();
+            return;
+        case Throughput:
+            _step = Done;
+            _report.insert("finished", QDateTime::currentDateTime().toString(Qt::ISODate));
+            emit finished(_report);
+            return;
+        case Done:
+            return;
+    }
+}
+
+void LinkDiagnostics::probeTcpConnect() {
+    QTcpSocket*   socket = new QTcpSocket(this);
+    QElapsedTimer timer;
+    timer.start();
+
+    auto done = [=](bool connected) {
+        if (connected) {
+            _latency.add(timer.elapsed());
+        }
+        QObject::disconnect(socket, nullptr, this, nullptr);
+        socket->abort();
+        socket->deleteLater();
+        next();
+    };
+    QObject::connect(socket, &QTcpSocket::connected, this, [=]() { done(true); });
+    QObject::connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this,
+                     [=]() { done(false); });
+    // a host which doesn't answer at all
+    QTimer::singleShot(PROBE_TIMEOUT, socket, [=]() { done(false); });
+    socket->connectToHost(_host, _port);
+}
+
+void LinkDiagnostics::probeRpc() {
+    QElapsedTimer timer;
+    timer.start();
+
+    QNetworkReply* reply = _nam->post(_rpcRequest, rpcJson({"version", "?"}));
+    abortAfterTimeout(reply);
+    QObject::connect(reply, &QNetworkReply::finished, this, [=]() {
+        reply->deleteLater();
+        if (reply->error() == QNetworkReply::NoError) {
+            _latency.add(timer.elapsed());
+        }
+        next();
+    });
+}
+
+void LinkDiagnostics::probePush() {
+    // one shot guard: the probe may call back late after a timeout
+    QSharedPointer<bool> answered(new bool(false));
+    auto done = [=](qint64 latency) {
+        if (*answered) {
+            return;
+        }
+        *answered = true;
+        if (latency >= 0) {
+            _latency.add(latency);
+        }
+        next();
+    };
+    QTimer::singleShot(PROBE_TIMEOUT, this, [=]() { done(-1); });
+    _pushProbe(done);
+}
+
+void LinkDiagnostics::probeThroughput() {
+    // the track list of the library is the largest reply a server usually has
+    QElapsedTimer          timer;
+    QSharedPointer<qint64> firstByte(new qint64(-1));
+    QSharedPointer<qint64> bytes(new qint64(0));
+    timer.start();
+
+    QNetworkReply* reply = _nam->post(_rpcRequest, rpcJson({"titles", "0", "5000", "tags:al"}));
+    abortAfterTimeout(reply);
+    QObject::connect(reply, &QNetworkReply::readyRead, this, [=]() {
+        if (*firstByte < 0) {
+            *firstByte = timer.elapsed();
+        }
+        *bytes += reply->readAll().size();
+    });
+    QObject::connect(reply, &QNetworkReply::finished, this, [=]() {
+        reply->deleteLater();
+        *bytes += reply->readAll().size();
+
+        qint64      elapsed = timer.elapsed();
+        qint64      transfer = qMax<qint64>(1, elapsed - qMax<qint64>(0, *firstByte));
+        QVariantMap throughput;
+        throughput.insert("bytes", *bytes);
+        throughput.insert("firstByteMs", *firstByte);
+        throughput.insert("totalMs", elapsed);
+        throughput.insert("kBytesPerSecond", *bytes / transfer);
+        throughput.insert("error", reply->error() == QNetworkReply::NoError ? QString() : reply->errorString());
+        _report.insert("throughput", throughput);
+        next();
+    });
+}
+
+void LinkDiagnostics::abortAfterTimeout(QNetworkReply* reply) {
+    QTimer::singleShot(PROBE_TIMEOUT, reply, &QNetworkReply::abort);
+}
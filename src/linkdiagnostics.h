@@ -0,0 +1,71 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QVariantMap>
+#include <functional>
+
+#include "latencystats.h"
+
+// On demand measurement of the link to the Squeezebox server: TCP connect time, JSON-RPC round trip times, CometD
+// push latency and the throughput of a large reply. The result is a report the app can show or export.
+class LinkDiagnostics : public QObject {
+    Q_OBJECT
+
+ public:
+    // a CometD round trip to the server, calls back with the latency in ms or -1
+    typedef std::function<void(const std::function<void(qint64)>&)> PushProbe;
+
+    LinkDiagnostics(QNetworkAccessManager* nam, const QString& host, int port, const QNetworkRequest& rpcRequest,
+                    const PushProbe& pushProbe, QObject* parent = nullptr);
+
+    void start();
+
+ signals:
+    void finished(const QVariantMap& report);
+
+ private:
+    enum Step { TcpConnect, RpcRoundTrip, PushRoundTrip, Throughput, Done };
+
+    void next();
+    void probeTcpConnect();
+    void probeRpc();
+    void probePush();
+    void probeThroughput();
+    void abortAfterTimeout(QNetworkReply* reply);
+
+    QNetworkAccessManager* _nam;
+    QString                _host;
+    int                    _port;
+    QNetworkRequest        _rpcRequest;
+    PushProbe              _pushProbe;
+    Step                   _step;
+    int                    _samples;
+    LatencyStats           _latency;  // milliseconds of the current step
+    QVariantMap            _report;
+};
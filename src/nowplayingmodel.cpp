@@ -0,0 +1,148 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "nowplayingmodel.h"
+
+#include <algorithm>
+
+NowPlayingModel::NowPlayingModel(QObject* parent) : QAbstractListModel(parent) {}
+
+int NowPlayingModel::rowCount(const QModelIndex& parent) const {
+    if (parent.isValid()) {
+        return 0;
+    }
+    return _items.size();
+}
+
+QVariant NowPlayingModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= _items.size()) {
+        return QVariant();
+    }
+
+    const Item& item = _items.at(index.row());
+    switch (role) {
+        case PlayerIdRole:
+            return item.playerId;
+        case NameRole:
+        case Qt::DisplayRole:
+            return item.name;
+        case StateRole:
+            return item.state;
+        case TitleRole:
+            return item.title;
+        case ArtistRole:
+            return item.artist;
+        case ImageRole:
+            return item.image;
+        case ActivityRole:
+            return item.lastActivity;
+        case PlaceholderRole:
+            return item.placeholder;
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> NowPlayingModel::roleNames() const {
+    QHash<int, QByteArray> roles;
+    roles[PlayerIdRole] = "playerId";
+    roles[NameRole] = "name";
+    roles[StateRole] = "state";
+    roles[TitleRole] = "title";
+    roles[ArtistRole] = "artist";
+    roles[ImageRole] = "image";
+    roles[ActivityRole] = "lastActivity";
+    roles[PlaceholderRole] = "placeholder";
+    return roles;
+}
+
+void NowPlayingModel::update(const Item& item) {
+    int row = _rows.value(item.playerId, -1);
+
+    if (row < 0) {
+        int position = insertPosition(item.lastActivity);
+        beginInsertRows(QModelIndex(), position, position);
+        _items.insert(position, item);
+        reindex(position, _items.size() - 1);
+        endInsertRows();
+        return;
+    }
+
+    if (item.lastActivity != _items.at(row).lastActivity) {
+        // destination is counted in the list before the move, the target row after it
+        int destination = insertPosition(item.lastActivity);
+        int target = row < destination ? destination - 1 : destination;
+        if (target != row) {
+            beginMoveRows(QModelIndex(), row, row, QModelIndex(), destination);
+            _items.move(row, target);
+            reindex(qMin(row, target), qMax(row, target));
+            endMoveRows();
+            row = target;
+        }
+    }
+
+    Item& current = _items[row];
+    if (current.name == item.name && current.state == item.state && current.title == item.title &&
+        current.artist == item.artist && current.image == item.image && current.lastActivity == item.lastActivity &&
+        current.placeholder == item.placeholder) {
+        return;
+    }
+    current = item;
+
+    QModelIndex changed = index(row);
+    emit dataChanged(changed, changed);
+}
+
+void NowPlayingModel::remove(const QString& playerId) {
+    int row = _rows.value(playerId, -1);
+    if (row < 0) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    _items.remove(row);
+    _rows.remove(playerId);
+    reindex(row, _items.size() - 1);
+    endRemoveRows();
+}
+
+void NowPlayingModel::updatePlaceholder(const QString& coverId, const QStringList& placeholder) {
+    for (int row = 0; row < _items.size(); ++row) {
+        if (_items.at(row).coverId == coverId && _items.at(row).placeholder != placeholder) {
+            _items[row].placeholder = placeholder;
+            QModelIndex changed = index(row);
+            emit dataChanged(changed, changed, {PlaceholderRole});
+        }
+    }
+}
+
+int NowPlayingModel::insertPosition(qint64 lastActivity) const {
+    // first row which is less recently active, equal rows keep their order
+    auto it = std::lower_bound(_items.constBegin(), _items.constEnd(), lastActivity,
+                               [](const Item& item, qint64 value) { return item.lastActivity >= value; });
+    return static_cast<int>(it - _items.constBegin());
+}
+
+void NowPlayingModel::reindex(int first, int last) {
+    for (int i = first; i <= last; ++i) {
+        _rows.insert(_items.at(i).playerId, i);
+    }
+}
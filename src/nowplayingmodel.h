@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// List of all active players, most recently active player first.
+// Rows are inserted, moved and updated one at a time, the list is never rebuilt.
+class NowPlayingModel : public QAbstractListModel {
+    Q_OBJECT
+
+ public:
+    enum Roles {
+        PlayerIdRole = Qt::UserRole + 1,
+        NameRole,
+        StateRole,
+        TitleRole,
+        ArtistRole,
+        ImageRole,
+        ActivityRole,
+        PlaceholderRole
+    };
+
+    struct Item {
+        QString     playerId;
+        QString     name;
+        int         state = 0;
+        QString     title;
+        QString     artist;
+        QString     image;
+        qint64      lastActivity = 0;  // msecs since epoch of the last track or mode change
+        QString     coverId;
+        QStringList placeholder;  // colors of the cover, shown until the image is loaded
+    };
+
+    explicit NowPlayingModel(QObject* parent = nullptr);
+
+    int                    rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant               data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    void update(const Item& item);
+    void remove(const QString& playerId);
+    void updatePlaceholder(const QString& coverId, const QStringList& placeholder);
+
+ private:
+    int  insertPosition(qint64 lastActivity) const;
+    void reindex(int first, int last);
+
+    QVector<Item>       _items;  // sorted by lastActivity, descending
+    QHash<QString, int> _rows;   // key: player mac, value: row in _items
+};
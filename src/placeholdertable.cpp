@@ -0,0 +1,154 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "placeholdertable.h"
+
+#include <QColor>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QtEndian>
+
+PlaceholderTable::PlaceholderTable(const QString& directory) : _file(directory + "/placeholders.dat") {
+    QDir().mkpath(directory);
+    load();
+}
+
+QByteArray PlaceholderTable::compute(const QByteArray& image) {
+    QImage decoded;
+    if (!decoded.loadFromData(image) || decoded.width() < GRID || decoded.height() < GRID) {
+        return QByteArray();
+    }
+    decoded = decoded.convertToFormat(QImage::Format_RGB32);
+
+    // average of each cell, the borders are spread evenly if the size is not a multiple of the grid
+    QByteArray grid;
+    grid.reserve(GRID * GRID * 3);
+    for (int row = 0; row < GRID; ++row) {
+        int top = row * decoded.height() / GRID;
+        int bottom = (row + 1) * decoded.height() / GRID;
+        for (int column = 0; column < GRID; ++column) {
+            int    left = column * decoded.width() / GRID;
+            int    right = (column + 1) * decoded.width() / GRID;
+            qint64 red = 0, green = 0, blue = 0;
+            for (int y = top; y < bottom; ++y) {
+                const QRgb* line = reinterpret_cast<const QRgb*>(decoded.constScanLine(y));
+                for (int x = left; x < right; ++x) {
+                    red += qRed(line[x]);
+                    green += qGreen(line[x]);
+                    blue += qBlue(line[x]);
+                }
+            }
+            qint64 pixels = static_cast<qint64>(bottom - top) * (right - left);
+            grid.append(static_cast<char>(red / pixels));
+            grid.append(static_cast<char>(green / pixels));
+            grid.append(static_cast<char>(blue / pixels));
+        }
+    }
+    return grid;
+}
+
+QStringList PlaceholderTable::colors(const QString& coverId) const {
+    QStringList result;
+    QByteArray  grid = _grids.value(key(coverId));
+    for (int i = 0; i + 2 < grid.size(); i += 3) {
+        result.append(QColor(static_cast<quint8>(grid[i]), static_cast<quint8>(grid[i + 1]),
+                             static_cast<quint8>(grid[i + 2]))
+                          .name());
+    }
+    return result;
+}
+
+void PlaceholderTable::insert(const QString& coverId, const QByteArray& grid) {
+    quint64 id = key(coverId);
+    if (grid.size() != GRID_BYTES || _grids.contains(id)) {
+        return;
+    }
+    _grids.insert(id, grid);
+    _order.append(id);
+
+    // cover ids never change their image, so records are only appended until the table is pruned
+    if (_grids.size() > MAX_ENTRIES) {
+        _grids.remove(_order.takeFirst());
+        if (_records >= MAX_ENTRIES * 5 / 4) {
+            rewrite();
+            return;
+        }
+    }
+
+    QFile file(_file);
+    if (!file.open(QIODevice::Append)) {
+        return;
+    }
+    QByteArray record(8, 0);
+    qToLittleEndian<quint64>(id, record.data());
+    if (file.write(record + grid) == RECORD_BYTES) {
+        _records++;
+    }
+}
+
+quint64 PlaceholderTable::key(const QString& coverId) {
+    return qFromLittleEndian<quint64>(QCryptographicHash::hash(coverId.toUtf8(), QCryptographicHash::Sha1).constData());
+}
+
+void PlaceholderTable::load() {
+    QFile file(_file);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    // a record cut off by a crash while appending is ignored
+    QByteArray data = file.readAll();
+    _records = data.size() / RECORD_BYTES;
+    for (int offset = 0; offset + RECORD_BYTES <= data.size(); offset += RECORD_BYTES) {
+        quint64 id = qFromLittleEndian<quint64>(data.constData() + offset);
+        if (!_grids.contains(id)) {
+            _grids.insert(id, data.mid(offset + 8, GRID_BYTES));
+            _order.append(id);
+        }
+    }
+    file.close();
+
+    while (_grids.size() > MAX_ENTRIES) {
+        _grids.remove(_order.takeFirst());
+    }
+    if (_records != _grids.size() || data.size() % RECORD_BYTES != 0) {
+        rewrite();
+    }
+}
+
+void PlaceholderTable::rewrite() {
+    // only the grids still in the table, oldest first
+    QByteArray data;
+    data.reserve(_order.size() * RECORD_BYTES);
+    for (quint64 id : _order) {
+        QByteArray record(8, 0);
+        qToLittleEndian<quint64>(id, record.data());
+        data.append(record).append(_grids.value(id));
+    }
+
+    QFile file(_file);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(data) == data.size()) {
+        _records = _order.size();
+    }
+}
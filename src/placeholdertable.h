@@ -0,0 +1,62 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Tiny placeholders of the cover art: a 4x4 grid of average colors per cover id, painted by the UI while the
+// artwork is loading. The grids are appended to a file in the cache directory as fixed records of 56 bytes: an
+// 8 byte hash of the cover id and 48 bytes of colors. Only the newest MAX_ENTRIES grids are kept.
+class PlaceholderTable {
+ public:
+    static const int GRID = 4;
+    static const int MAX_ENTRIES = 20000;
+
+    explicit PlaceholderTable(const QString& directory);
+
+    // grid of an encoded image, GRID * GRID RGB triples row by row, empty if the image can't be decoded.
+    // Thread safe, run it off the UI thread.
+    static QByteArray compute(const QByteArray& image);
+
+    bool        contains(const QString& coverId) const { return _grids.contains(key(coverId)); }
+    QStringList colors(const QString& coverId) const;  // "#rrggbb" row by row, empty if unknown
+    void        insert(const QString& coverId, const QByteArray& grid);
+
+ private:
+    static const int GRID_BYTES = GRID * GRID * 3;
+    static const int RECORD_BYTES = 8 + GRID_BYTES;
+
+    static quint64 key(const QString& coverId);
+
+    void load();
+    void rewrite();
+
+    QString                    _file;
+    QHash<quint64, QByteArray> _grids;        // key: hash of the cover id
+    QVector<quint64>           _order;        // oldest first
+    int                        _records = 0;  // in the file, including pruned ones
+};
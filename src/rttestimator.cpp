@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "rttestimator.h"
+
+#include <QtGlobal>
+
+RttEstimator::RttEstimator(int minTimeout, int maxTimeout, int initialTimeout)
+    : _minTimeout(minTimeout),
+      _maxTimeout(maxTimeout),
+      _initialTimeout(initialTimeout),
+      _srtt(0),
+      _rttvar(0),
+      _samples(0),
+      _backoff(1) {}
+
+void RttEstimator::add(qint64 msecs) {
+    double rtt = static_cast<double>(msecs);
+    if (_samples == 0) {
+        _srtt = rtt;
+        _rttvar = rtt / 2;
+    } else {
+        // the variation is updated with the old average
+        _rttvar = 0.75 * _rttvar + 0.25 * qAbs(_srtt - rtt);
+        _srtt = 0.875 * _srtt + 0.125 * rtt;
+    }
+    _samples++;
+    _backoff = 1;
+}
+
+void RttEstimator::backoff() {
+    if (timeout() < _maxTimeout) {
+        _backoff *= 2;
+    }
+}
+
+void RttEstimator::setBounds(int minTimeout, int maxTimeout) {
+    _minTimeout = minTimeout;
+    _maxTimeout = qMax(minTimeout, maxTimeout);
+}
+
+int RttEstimator::timeout() const {
+    double timeout = _samples == 0 ? _initialTimeout : _srtt + qMax(1.0, 4 * _rttvar);
+    return static_cast<int>(qBound(static_cast<double>(_minTimeout), timeout * _backoff,
+                                   static_cast<double>(_maxTimeout)));
+}
+
+QVariantMap RttEstimator::toMap() const {
+    QVariantMap map;
+    map.insert("samples", _samples);
+    map.insert("srtt", qRound(_srtt));
+    map.insert("rttvar", qRound(_rttvar));
+    map.insert("timeout", timeout());
+    map.insert("min", _minTimeout);
+    map.insert("max", _maxTimeout);
+    return map;
+}
@@ -0,0 +1,50 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QVariantMap>
+
+// Retransmission timeout from round trip samples in milliseconds, computed like TCP does (RFC 6298):
+// smoothed round trip time plus four times its variation, clamped to the configured bounds.
+class RttEstimator {
+ public:
+    RttEstimator(int minTimeout, int maxTimeout, int initialTimeout);
+
+    void   add(qint64 msecs);
+    void   backoff();  // after a timeout, until the next sample
+    void   setBounds(int minTimeout, int maxTimeout);
+    int    timeout() const;
+    double srtt() const { return _srtt; }
+    double rttvar() const { return _rttvar; }
+
+    QVariantMap toMap() const;  // srtt, rttvar, timeout and bounds
+
+ private:
+    int    _minTimeout;
+    int    _maxTimeout;
+    int    _initialTimeout;
+    double _srtt;
+    double _rttvar;
+    int    _samples;
+    int    _backoff;
+};
@@ -23,12 +23,19 @@
 #include "squeezebox.h"
 
 #include <QColor>
+#include <QDateTime>
+#include <QFutureWatcher>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QQmlEngine>
 #include <QSet>
+#include <QStandardPaths>
 #include <QString>
+#include <QUdpSocket>
+#include <QtConcurrent>
 #include <QtDebug>
 
+#include "statusdecoder.h"
 #include "yio-interface/entities/blindinterface.h"
 #include "yio-interface/entities/entityinterface.h"
 #include "yio-interface/entities/lightinterface.h"
@@ -47,33 +54,75 @@ Integration* SqueezeboxPlugin::createIntegration(const QVariantMap& config, Enti
 
 Squeezebox::Squeezebox(const QVariantMap& config, EntitiesInterface* entities, NotificationsInterface* notifications,
                        YioAPIInterface* api, ConfigInterface* configObj, Plugin* plugin)
-    : Integration(config, entities, notifications, api, configObj, plugin), _nam(this), _socket(this) {
+    : Integration(config, entities, notifications, api, configObj, plugin),
+      _nam(this),
+      _socket(this),
+      _progressTicks(true),
+      _nowPlaying(this),
+      _hedging(false),
+      _hedgeBudget(1.0),
+      _browseCache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/squeezebox"),
+      _trackInfoCache(200),
+      _diagnostics(nullptr),
+      _rtt(1000, 10000, 3000),
+      _placeholders(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/squeezebox"),
+      _thumbnails(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/squeezebox",
+                  config.value("thumbnailCache", 64).toLongLong() * 1024 * 1024, this),
+      _thumbnailFetcher(&_nam, &_thumbnails, this),
+      _library(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/squeezebox"),
+      _libraryUpdating(false),
+      _libraryBuild(0) {
     for (QVariantMap::const_iterator iter = config.begin(); iter != config.end(); ++iter) {
         if (iter.key() == "url") {
             _url = iter.value().toString();
         } else if (iter.key() == "port") {
             _port = iter.value().toInt();
+        } else if (iter.key() == "mac") {
+            _mac = iter.value().toString().remove(':').remove('-');
+        } else if (iter.key() == "hedging") {
+            _hedging = iter.value().toBool();
+        } else if (iter.key() == "progressTicks") {
+            _progressTicks = iter.value().toBool();
         }
     }
+    _rtt.setBounds(config.value("timeoutMin", 1000).toInt(), config.value("timeoutMax", 10000).toInt());
 
     _httpurl = "http://" + _url + ":" + QString::number(_port) + "/";
+    _thumbnailFetcher.setServer(_httpurl);
+    QObject::connect(&_thumbnailFetcher, &ThumbnailFetcher::thumbnailReady, this, &Squeezebox::thumbnailReady);
+
+    if (!_mac.isEmpty() && QByteArray::fromHex(_mac.toLatin1()).size() != 6) {
+        qCWarning(m_logCategory) << "Invalid MAC address, Wake-on-LAN is disabled:" << _mac;
+        _mac.clear();
+    }
 
     _connectionState = idle;
 
     // read added entities
-    _myEntities = m_entities->getByIntegration(integrationId());
-    for (auto entity : _myEntities) {
-        _sqPlayerDatabase.insert(entity->entity_id(), SqPlayer());
-    }
+    refreshEntities();
 
-    // prepare connection timeout timer
+    // prepare connection timeout timer, each handshake step gets its own timeout from the measured round trips
     _connectionTimeout.setSingleShot(true);
-    _connectionTimeout.setInterval(3 * 1000);
+    _connectionTimeout.setInterval(_rtt.timeout());
     _connectionTimeout.stop();
 
     QObject::connect(&_connectionTimeout, &QTimer::timeout, this, &Squeezebox::onConnectionTimeoutTimer);
 
     _connectionTries = 0;
+    _userDisconnect = true;
+    _discovered = false;
+    _resumeOnNetwork = false;
+    _resuming = false;
+    _clock.start();
+    _pendingSubscriptions = 0;
+    _handshakeDuration = 0;
+    _entityUpdates = 0;
+    _waking = false;
+    _wakeDelay = 250;
+    _wakePacketSent = 0;
+
+    _wakePoll.setSingleShot(true);
+    QObject::connect(&_wakePoll, &QTimer::timeout, this, &Squeezebox::onWakePollTimer);
 
     // prepare media progress timer
     _mediaProgress.setSingleShot(false);
@@ -82,6 +131,19 @@ Squeezebox::Squeezebox(const QVariantMap& config, EntitiesInterface* entities, N
 
     QObject::connect(&_mediaProgress, &QTimer::timeout, this, &Squeezebox::onMediaProgressTimer);
 
+    // rapid next/previous presses become a single jump per player
+    _skipTimer.setSingleShot(true);
+
+    QObject::connect(&_skipTimer, &QTimer::timeout, this, &Squeezebox::onSkipTimer);
+
+    // prepare lost update detection
+    _lostUpdates = 0;
+    _pushWatchdog.setSingleShot(false);
+    _pushWatchdog.setInterval(15 * 1000);
+    _pushWatchdog.stop();
+
+    QObject::connect(&_pushWatchdog, &QTimer::timeout, this, &Squeezebox::onPushWatchdogTimer);
+
     QObject::connect(&_socket, &QTcpSocket::connected, this, &Squeezebox::socketConnected);
     QObject::connect(&_socket, &QIODevice::readyRead, this, &Squeezebox::socketReceived);
     QObject::connect(&_socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this,
@@ -93,10 +155,56 @@ Squeezebox::Squeezebox(const QVariantMap& config, EntitiesInterface* entities, N
     qCDebug(m_logCategory) << "setup";
 }
 
+Squeezebox::~Squeezebox() {
+    // the provider outlives the integration, requests still reading the store finish first
+    if (!_thumbnailSource.isNull()) {
+        _thumbnailSource->release(&_thumbnails);
+    }
+}
+
 void Squeezebox::networkAccessibleChanged(QNetworkAccessManager::NetworkAccessibility accessible) {
     if (accessible != QNetworkAccessManager::NetworkAccessibility::Accessible) {
+        // come back by ourself if the connection wasn't closed on purpose
+        if (!_userDisconnect) {
+            _resumeOnNetwork = true;
+        }
         disconnect();
+    } else if (_resumeOnNetwork) {
+        _resumeOnNetwork = false;
+        resume();
+    }
+}
+
+void Squeezebox::resume() {
+    _resumeTimer.start();
+    _resuming = true;
+
+    if (!_discovered) {
+        connect();
+        return;
     }
+
+    // server and players are known from the last session: the cached entity states stay valid until the
+    // subscriptions push fresh status, so the discovery request is skipped
+    qCDebug(m_logCategory) << "Network is back, resuming the last session";
+    setState(CONNECTING);
+    _userDisconnect = false;
+
+    _handshakeTimer.start();
+    connectSocket();
+
+    // players added or removed during the standby are only found by a discovery, the count tells if one is needed
+    sqRead(
+        "-", "players 0 0",
+        [=](const QVariantMap& results) {
+            int count = results.value("count").toInt();
+            if (count != _playerCnt && !_userDisconnect) {
+                qCInfo(m_logCategory) << "Server reports" << count << "instead of" << _playerCnt
+                                      << "player/s, discovering again";
+                connect();
+            }
+        },
+        true);
 }
 
 void Squeezebox::connect() {
@@ -105,19 +213,46 @@ void Squeezebox::connect() {
 
     qCDebug(m_logCategory) << "Try to connect for the " << QString::number(_connectionTries + 1) << "st/nd time";
 
-    _connectionTimeout.start();
+    // a retry starts from scratch, otherwise stale subscriptions pile up
+    closeSession();
+    refreshEntities();
+
+    _handshakeTimer.start();
+    startStep();
     getPlayers();
 }
 
 void Squeezebox::disconnect() {
     _userDisconnect = true;
+    _waking = false;
+    _wakePoll.stop();
 
-    _socket.close();
+    closeSession();
     _mediaProgress.stop();
+    _thumbnailFetcher.cancel();
 
     setState(DISCONNECTED);
 }
 
+void Squeezebox::closeSession() {
+    _socket.abort();
+    _pushWatchdog.stop();
+
+    // subscriptions end with the socket
+    for (QMap<QString, SqPlayer>::iterator i = _sqPlayerDatabase.begin(); i != _sqPlayerDatabase.end(); ++i) {
+        i->subscribed = false;
+    }
+    _sqPlayerIdMapping.clear();
+    _libraryBuild++;
+
+    // scene requests still waiting for an acknowledgement are lost
+    QHash<int, SqGroupRequest> groupRequests = _groupRequests;
+    _groupRequests.clear();
+    for (const SqGroupRequest& request : groupRequests) {
+        groupResult(request.group, request.player, false);
+    }
+}
+
 void Squeezebox::enterStandby() {
     _mediaProgress.stop();
     _inStandby = true;
@@ -137,8 +272,17 @@ void Squeezebox::onConnectionTimeoutTimer() {
         _connectionTries = 0;
         return;
     }
+    _rtt.backoff();
 
     if (_connectionTries == 3) {
+        _connectionTries = 0;
+
+        // the server may just be asleep
+        if (!_mac.isEmpty() && !_waking) {
+            wakeServer();
+            return;
+        }
+
         disconnect();
 
         qCCritical(m_logCategory) << "Cannot connect to Squeezebox server: retried 3 times connecting to" << _url;
@@ -150,14 +294,70 @@ void Squeezebox::onConnectionTimeoutTimer() {
                                  i->connect();
                              },
                              param);
-
-        _connectionTries = 0;
     } else {
         _connectionTries++;
         connect();
     }
 }
 
+void Squeezebox::wakeServer() {
+    qCInfo(m_logCategory) << "Server not reachable, waking it up with Wake-on-LAN";
+    _waking = true;
+    _wakeTimer.start();
+    _wakeDelay = 250;
+
+    sendMagicPacket();
+    _wakePoll.start(_wakeDelay);
+}
+
+void Squeezebox::sendMagicPacket() {
+    // 6 times 0xFF followed by 16 times the MAC address
+    QByteArray mac = QByteArray::fromHex(_mac.toLatin1());
+    QByteArray packet(6, static_cast<char>(0xFF));
+    for (int i = 0; i < 16; ++i) {
+        packet.append(mac);
+    }
+
+    QUdpSocket socket;
+    socket.writeDatagram(packet, QHostAddress::Broadcast, 9);
+    _wakePacketSent = _wakeTimer.elapsed();
+}
+
+void Squeezebox::onWakePollTimer() {
+    if (_wakeTimer.elapsed() > 120 * 1000) {
+        // the regular retries run once more and report the failure
+        qCWarning(m_logCategory) << "Server did not wake up within 2 minutes";
+        _connectionTries = 3;
+        _connectionTimeout.start();
+        return;
+    }
+
+    // the packet may get lost while the network link of the server is powering up
+    if (_wakeTimer.elapsed() - _wakePacketSent > 5 * 1000) {
+        sendMagicPacket();
+    }
+
+    // cheapest request the server answers as soon as it is up
+    QNetworkReply* reply = _nam.post(buildRpcRequest(), buildRpcJson(1, "-", "version ?"));
+    QTimer::singleShot(qMin(_wakeDelay * 2, 1000), reply, &QNetworkReply::abort);
+    QObject::connect(reply, &QNetworkReply::finished, this, [=]() {
+        reply->deleteLater();
+        if (!_waking || _userDisconnect) {
+            return;
+        }
+
+        if (reply->error() == QNetworkReply::NoError) {
+            qCInfo(m_logCategory) << "Server answered" << _wakeTimer.elapsed() << "ms after Wake-on-LAN";
+            connect();
+            return;
+        }
+
+        // aggressive at first, then back off
+        _wakeDelay = qMin(_wakeDelay * 3 / 2, 2000);
+        _wakePoll.start(_wakeDelay);
+    });
+}
+
 QByteArray Squeezebox::buildRpcJson(int id, const QString& player, const QString& command) {
     QJsonArray arr = QJsonArray();
     arr.append(player);
@@ -182,90 +382,364 @@ QNetworkRequest Squeezebox::buildRpcRequest() {
 void Squeezebox::getPlayers() {
     _connectionState = playerInfo;
 
-    QNetworkReply* reply = _nam.post(buildRpcRequest(), buildRpcJson(1, "-", "players 0 99"));
-    QObject::connect(reply, QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::error), this,
-                     &Squeezebox::networkError);
-    QObject::connect(reply, &QNetworkReply::finished, this, [=]() {
-        QString         answer = reply->readAll();
-        QJsonParseError parseerror;
-        QJsonDocument   doc = QJsonDocument::fromJson(answer.toUtf8(), &parseerror);
+    // players removed from the server are not reported again
+    _serverPlayers.clear();
+    for (QMap<QString, SqPlayer>::iterator i = _sqPlayerDatabase.begin(); i != _sqPlayerDatabase.end(); ++i) {
+        i->connected = false;
+    }
 
-        if (parseerror.error != QJsonParseError::NoError) {
-            jsonError(parseerror.errorString());
+    // players are set up while the reply is still loading
+    auto addPlayer = [=](const QString& loop, const QVariantMap& player) {
+        if (loop != "players_loop") {
             return;
         }
+        QString playerid = player["playerid"].toString();
+
+        QStringList features({"MEDIA_ALBUM", "MEDIA_ARTIST", "MEDIA_DURATION", "MEDIA_POSITION", "MEDIA_IMAGE",
+                              "MEDIA_TITLE", "MEDIA_TYPE",   "MUTE",           "MUTE_SET",       "NEXT",
+                              "PAUSE",       "PLAY",         "PREVIOUS",       "SEARCH",         "SEEK",
+                              "STOP",        "VOLUME",       "VOLUME_SET",     "VOLUME_UP",      "VOLUME_DOWN"});
+        if (player["canpoweroff"].toBool()) {
+            features.append({"TURN_OFF", "TURN_ON"});
+        }
 
-        QVariantMap map = doc.toVariant().toMap();
-        QVariantMap results = qvariant_cast<QVariantMap>(map.value("result"));
+        addAvailableEntity(playerid, "media_player", integrationId(), player["name"].toString(), features);
+        _serverPlayers.insert(playerid, player["name"].toString());
 
+        if (_sqPlayerDatabase.contains(playerid)) {
+            _sqPlayerDatabase[playerid].connected = true;
+            _sqPlayerDatabase[playerid].name = player["name"].toString();
+            getPlayerStatus(playerid);
+        }
+    };
+
+    sqReadStream("-", "players 0 99", addPlayer, [=](const QVariantMap& results) {
         _playerCnt = results.value("count").toInt();
 
-        QVariantList players = results.value("players_loop").toList();
-        while (!players.isEmpty()) {
-            auto    player = players.takeFirst().toMap();
-            QString playerid = player["playerid"].toString();
-
-            QStringList features({"MEDIA_ALBUM", "MEDIA_ARTIST", "MEDIA_DURATION", "MEDIA_POSITION", "MEDIA_IMAGE",
-                                  "MEDIA_TITLE", "MEDIA_TYPE",   "MUTE",           "MUTE_SET",       "NEXT",
-                                  "PAUSE",       "PLAY",         "PREVIOUS",       "SEARCH",         "SEEK",
-                                  "STOP",        "VOLUME",       "VOLUME_SET",     "VOLUME_UP",      "VOLUME_DOWN"});
-            if (player["canpoweroff"].toBool()) {
-                features.append({"TURN_OFF", "TURN_ON"});
-            }
+        // HERE: suche nicht verbundene player
+        qCDebug(m_logCategory) << "Server reported " << _playerCnt << "player/s";
+        _discovered = true;
+
+        connectSocket();
+    });
+}
 
-            addAvailableEntity(playerid, "media_player", integrationId(), player["name"].toString(), features);
+void Squeezebox::refreshEntities() {
+    QList<EntityInterface*> entities = m_entities->getByIntegration(integrationId());
+    QSet<QString>           entityIds;
 
-            if (_sqPlayerDatabase.contains(playerid)) {
-                _sqPlayerDatabase[playerid].connected = true;
-                getPlayerStatus(playerid);
-            }
+    for (EntityInterface* entity : entities) {
+        QString playerMac = entity->entity_id();
+        entityIds.insert(playerMac);
+        if (!_sqPlayerDatabase.contains(playerMac)) {
+            addPlayer(playerMac, entity);
+        }
+    }
+    for (const QString& playerMac : _sqPlayerDatabase.keys()) {
+        if (!entityIds.contains(playerMac)) {
+            removePlayer(playerMac);
         }
+    }
 
-        // HERE: suche nicht verbundene player
-        qCDebug(m_logCategory) << "Server reported " << _playerCnt << "player/s";
+    _myEntities = entities;
+}
 
-        // connect to socket
-        _socket.connectToHost(_url, _port);
-    });
+void Squeezebox::addPlayer(const QString& playerMac, EntityInterface* entity) {
+    SqPlayer player;
+    player.entity = entity;
+    _sqPlayerDatabase.insert(playerMac, player);
+    qCDebug(m_logCategory) << "Added player" << playerMac;
+
+    // before the discovery the player is set up by getPlayers()
+    if (!_serverPlayers.contains(playerMac)) {
+        return;
+    }
+    _sqPlayerDatabase[playerMac].connected = true;
+    _sqPlayerDatabase[playerMac].name = _serverPlayers.value(playerMac);
+    getPlayerStatus(playerMac);
+
+    // during the handshake the player is subscribed together with all others
+    if (_connectionState == connectionStates::connected) {
+        sendCometd(QJsonDocument(QJsonArray({subscribeMessage(playerMac)})).toJson());
+    }
+}
+
+void Squeezebox::removePlayer(const QString& playerMac) {
+    SqPlayer player = _sqPlayerDatabase.take(playerMac);
+    qCDebug(m_logCategory) << "Removed player" << playerMac;
+
+    // pushes stop right away, late ones are dropped because the subscription id is unknown
+    bool pending = false;
+    for (QMap<int, QString>::iterator i = _sqPlayerIdMapping.begin(); i != _sqPlayerIdMapping.end();) {
+        if (i.value() == playerMac) {
+            pending = !player.subscribed;
+            i = _sqPlayerIdMapping.erase(i);
+        } else {
+            ++i;
+        }
+    }
+    if (player.subscribed && _socket.state() == QAbstractSocket::ConnectedState) {
+        QJsonObject data = QJsonObject();
+        data.insert("unsubscribe", statusChannel(playerMac));
+
+        QJsonObject json = QJsonObject();
+        json.insert("channel", "/slim/unsubscribe");
+        json.insert("clientId", _clientId);
+        json.insert("data", data);
+
+        sendCometd(QJsonDocument(QJsonArray({json})).toJson());
+    }
+
+    _nowPlaying.remove(playerMac);
+
+    // the handshake must not wait for a subscription which is not counted any more
+    if (pending && (_connectionState == cometdConnect || _connectionState == cometdSubscribe)) {
+        _pendingSubscriptions--;
+        if (_connectionState == cometdSubscribe && _pendingSubscriptions == 0) {
+            sessionEstablished();
+        }
+    }
+}
+
+QString Squeezebox::statusChannel(const QString& playerMac) const {
+    // one response channel per player, so a single subscription can be cancelled
+    return _subscriptionChannel + "/" + QString(playerMac).remove(':');
+}
+
+void Squeezebox::connectSocket() {
+    startStep();
+    _socket.connectToHost(_url, _port);
+}
+
+void Squeezebox::trackCommand(const QString& playerMac, const QString& command, const QString& transport) {
+    auto player = _sqPlayerDatabase.find(playerMac);
+    if (player == _sqPlayerDatabase.end()) {
+        return;
+    }
+    player->commandSent = _clock.elapsed();
+    player->commandTransport = transport;
+
+    // what the status has to show, relative commands are confirmed by any change
+    QString argument = command.section(' ', -1);
+    bool    relative = argument.startsWith('+') || argument.startsWith('-');
+    int     volume = player->volume;
+    int     playlistIndex = player->playlistIndex;
+    if (command == "play" || command.startsWith("pause") || command == "stop") {
+        QString mode = command == "pause 0" ? "play" : command.section(' ', 0, 0);
+        player->commandConfirmed = [=](const QVariantMap& status) { return status.value("mode").toString() == mode; };
+    } else if (command.startsWith("power ")) {
+        player->commandConfirmed = [=](const QVariantMap& status) {
+            return status.value("power").toString() == argument;
+        };
+    } else if (command.startsWith("mixer muting")) {
+        player->commandConfirmed = [](const QVariantMap& status) { return status.value("mixer volume").toInt() < 0; };
+    } else if (command.startsWith("mixer volume") && !relative) {
+        int target = argument.toInt();
+        player->commandConfirmed = [=](const QVariantMap& status) {
+            return status.value("mixer volume").toInt() == target;
+        };
+    } else if (command.startsWith("mixer volume") || command.startsWith("button volume")) {
+        player->commandConfirmed = [=](const QVariantMap& status) {
+            return status.value("mixer volume").toInt() != volume;
+        };
+    } else if (command.startsWith("playlist ")) {
+        player->commandConfirmed = [=](const QVariantMap& status) {
+            return status.value("playlist_cur_index").toInt() != playlistIndex;
+        };
+    } else {
+        player->commandConfirmed = [](const QVariantMap&) { return true; };
+    }
 }
 
 void Squeezebox::getPlayerStatus(const QString& playerMac) {
-    QNetworkReply* reply = _nam.post(buildRpcRequest(), buildRpcJson(1, playerMac, _sqCmdPlayerStatus));
+    sqRead(
+        playerMac, _sqCmdPlayerStatus, [=](const QVariantMap& results) { parsePlayerStatus(playerMac, results); },
+        true, nullptr, true);
+}
+
+void Squeezebox::sqCommand(const QString& playerMac, const QString& command,
+                           const std::function<void(bool)>& done) {
+    trackCommand(playerMac, command, "http");
+
+    QElapsedTimer  timer;
+    QNetworkReply* reply = _nam.post(buildRpcRequest(), buildRpcJson(1, playerMac, command));
+    timer.start();
+    timeoutRequest(reply);
     QObject::connect(reply, QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::error), this,
                      &Squeezebox::networkError);
     QObject::connect(reply, &QNetworkReply::finished, this, [=]() {
-        QString         answer = reply->readAll();
+        reply->deleteLater();
+        if (reply->error() == QNetworkReply::NoError) {
+            _rtt.add(timer.elapsed());
+        }
+
         QJsonParseError parseerror;
-        QJsonDocument   doc = QJsonDocument::fromJson(answer.toUtf8(), &parseerror);
+        QJsonDocument::fromJson(reply->readAll(), &parseerror);
 
+        if (done) {
+            done(reply->error() == QNetworkReply::NoError && parseerror.error == QJsonParseError::NoError);
+        }
         if (parseerror.error != QJsonParseError::NoError) {
             jsonError(parseerror.errorString());
             return;
         }
 
-        QVariantMap map = doc.toVariant().toMap();
-        parsePlayerStatus(playerMac, qvariant_cast<QVariantMap>(map.value("result")));
+        qCDebug(m_logCategory) << "kommando gesendet";
     });
 }
 
-void Squeezebox::sqCommand(const QString& playerMac, const QString& command) {
-    QNetworkReply* reply = _nam.post(buildRpcRequest(), buildRpcJson(1, playerMac, command));
-    QObject::connect(reply, QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::error), this,
-                     &Squeezebox::networkError);
+void Squeezebox::sqRead(const QString& playerMac, const QString& command,
+                        const std::function<void(const QVariantMap&)>& callback, bool timed,
+                        const std::function<void()>& failed, bool hedgeable) {
+    QSharedPointer<SqRead> read(new SqRead());
+    read->json = buildRpcJson(1, playerMac, command);
+    read->callback = callback;
+    read->timed = timed;
+    read->failed = failed;
+    read->hedgeable = hedgeable;
+    startRead(read);
+}
+
+void Squeezebox::sqReadStream(const QString& playerMac, const QString& command,
+                              const JsonStreamReader::ItemCallback& items,
+                              const std::function<void(const QVariantMap&)>& callback,
+                              const std::function<void()>& failed, bool timed) {
+    QSharedPointer<SqRead> read(new SqRead());
+    read->json = buildRpcJson(1, playerMac, command);
+    read->callback = callback;
+    read->failed = failed;
+    read->timed = timed;
+    read->reader.reset(new JsonStreamReader(items));
+    startRead(read);
+}
+
+void Squeezebox::startRead(const QSharedPointer<SqRead>& read) {
+    read->timer.start();
+
+    postRead(read);
+
+    // a second copy of a streamed or library read would double the largest requests the server handles
+    if (_hedging && read->hedgeable) {
+        _hedgeBudget = qMin(_hedgeBudget + 0.1, 5.0);
+        QTimer::singleShot(hedgeDelay(), this, [=]() { hedgeRead(read); });
+    }
+}
+
+void Squeezebox::postRead(const QSharedPointer<SqRead>& read) {
+    QNetworkReply* reply = _nam.post(buildRpcRequest(), read->json);
+    reply->setProperty("hedged", read->hedgeSent > 0);
+    read->replies.append(reply);
+    if (read->timed) {
+        timeoutRequest(reply);
+    }
+
+    QObject::connect(reply, &QNetworkReply::readyRead, this, [=]() {
+        if (selectReadWinner(read, reply) && read->reader) {
+            read->reader->feed(reply->readAll());
+        }
+    });
     QObject::connect(reply, &QNetworkReply::finished, this, [=]() {
-        QString         answer = reply->readAll();
+        reply->deleteLater();
+
+        if (reply->error() != QNetworkReply::NoError) {
+            read->replies.removeOne(reply);
+            // a hedged copy may still answer
+            if (read->winner == reply || (read->winner == nullptr && read->replies.isEmpty())) {
+                networkError(reply->error());
+                if (read->failed) {
+                    read->failed();
+                }
+            }
+            return;
+        }
+        if (!selectReadWinner(read, reply)) {
+            return;
+        }
+
         QJsonParseError parseerror;
-        QJsonDocument   doc = QJsonDocument::fromJson(answer.toUtf8(), &parseerror);
+        QVariantMap     map;
+        if (read->reader) {
+            read->reader->feed(reply->readAll());
+            map = read->reader->finish(&parseerror);
+        } else {
+            map = QJsonDocument::fromJson(reply->readAll(), &parseerror).toVariant().toMap();
+        }
 
         if (parseerror.error != QJsonParseError::NoError) {
             jsonError(parseerror.errorString());
+            if (read->failed) {
+                read->failed();
+            }
             return;
         }
 
-        QVariantMap map = doc.toVariant().toMap();
-        QVariantMap results = qvariant_cast<QVariantMap>(map.value("result"));
+        read->callback(qvariant_cast<QVariantMap>(map.value("result")));
+    });
+}
+
+void Squeezebox::hedgeRead(const QSharedPointer<SqRead>& read) {
+    if (read->winner != nullptr || read->replies.size() != 1 || _hedgeBudget < 1.0) {
+        return;
+    }
 
-        qCDebug(m_logCategory) << "kommando gesendet";
+    _hedgeBudget -= 1.0;
+    read->hedgeSent = read->timer.elapsed();
+    qCDebug(m_logCategory) << "Hedging read after" << read->hedgeSent << "ms";
+    postRead(read);
+}
+
+bool Squeezebox::selectReadWinner(const QSharedPointer<SqRead>& read, QNetworkReply* reply) {
+    if (read->winner != nullptr) {
+        return read->winner == reply;
+    }
+
+    // first reply with data wins, the other one is cancelled
+    read->winner = reply;
+    qint64 latency = read->timer.elapsed() - (reply->property("hedged").toBool() ? read->hedgeSent : 0);
+    _readLatency.add(latency);
+    if (read->timed) {
+        _rtt.add(latency);
+    }
+
+    for (QNetworkReply* other : read->replies) {
+        if (other != reply) {
+            QObject::disconnect(other, nullptr, this, nullptr);
+            other->abort();
+            other->deleteLater();
+        }
+    }
+    read->replies = {reply};
+    return true;
+}
+
+int Squeezebox::hedgeDelay() const {
+    // hedge when a read takes longer than 95% of the recent reads
+    if (_readLatency.count() < 10) {
+        return 500;
+    }
+    return static_cast<int>(qBound<qint64>(50, _readLatency.percentile(95), 3000));
+}
+
+void Squeezebox::startStep() {
+    _stepTimer.start();
+    _connectionTimeout.start(_rtt.timeout());
+}
+
+void Squeezebox::finishStep() {
+    if (_stepTimer.isValid()) {
+        _rtt.add(_stepTimer.elapsed());
+        _stepTimer.invalidate();
+    }
+}
+
+void Squeezebox::timeoutRequest(QNetworkReply* reply) {
+    // no response header in time: the server or the link is gone, a request does not wait for the whole retry
+    QTimer::singleShot(_rtt.timeout(), reply, [=]() {
+        if (reply->isRunning() && !reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).isValid()) {
+            qCWarning(m_logCategory) << "Request timed out after" << _rtt.timeout() << "ms";
+            _rtt.backoff();
+            reply->abort();
+        }
     });
 }
 
@@ -279,6 +753,7 @@ void Squeezebox::sendCometd(const QByteArray& message) {
 
 void Squeezebox::socketConnected() {
     _connectionState = cometdHandshake;
+    finishStep();
 
     QJsonArray connectionTypes = QJsonArray();
     connectionTypes.append("long-polling");
@@ -292,10 +767,35 @@ void Squeezebox::socketConnected() {
     QJsonArray message = QJsonArray();
     message.append(json);
 
+    startStep();
     sendCometd(QJsonDocument(message).toJson());
     qCDebug(m_logCategory) << "connected to socket";
 }
 
+void Squeezebox::sessionEstablished() {
+    _connectionState = connectionStates::connected;
+    setState(CONNECTED);
+    _pushWatchdog.start();
+
+    qCInfo(m_logCategory) << "Connected with" << _sqPlayerIdMapping.size() << "subscription/s in"
+                          << _handshakeTimer.elapsed() << "ms";
+    _handshakeDuration = _handshakeTimer.elapsed();
+
+    if (_waking) {
+        _waking = false;
+        _wakeTime.add(_wakeTimer.elapsed());
+        qCInfo(m_logCategory) << "Connected" << _wakeTimer.elapsed() << "ms after Wake-on-LAN";
+    }
+
+    if (_resuming) {
+        _resuming = false;
+        qCInfo(m_logCategory) << "Resumed after network recovery in" << _resumeTimer.elapsed() << "ms";
+    }
+
+    prefetchMenus();
+    updateLibraryIndex();
+}
+
 void Squeezebox::socketError(QAbstractSocket::SocketError socketError) {
     if (_userDisconnect) {
         return;
@@ -315,60 +815,274 @@ void Squeezebox::networkError(QNetworkReply::NetworkError code) {
 }
 
 void Squeezebox::parsePlayerStatus(const QString& playerMac, const QVariantMap& data) {
-    EntityInterface* entity = m_entities->getEntityInterface(playerMac);
+    QElapsedTimer parseTime;
+    parseTime.start();
 
-    QVariantList playlist = data.value("playlist_loop").toList();
+    QMap<QString, SqPlayer>::iterator found = _sqPlayerDatabase.find(playerMac);
+    if (found == _sqPlayerDatabase.end() || found->entity == nullptr) {
+        return;
+    }
+    SqPlayer&        player = *found;
+    EntityInterface* entity = player.entity;
+    PlayerStatus     status = decodePlayerStatus(data);
+    bool             wasPlaying = player.isPlaying;
 
     // get current player status
-    if (!data.value("power").toBool()) {
-        entity->setState(MediaPlayerDef::OFF);
+    int state;
+    if (!status.power) {
+        state = MediaPlayerDef::OFF;
     } else {
-        entity->setState(MediaPlayerDef::ON);
+        state = MediaPlayerDef::ON;
 
-        if (data.value("mode").toString() == "play") {
-            entity->setState(MediaPlayerDef::PLAYING);
-            _sqPlayerDatabase[playerMac].isPlaying = true;
-            if (_inStandby == false) {
+        if (status.mode == "play") {
+            state = MediaPlayerDef::PLAYING;
+            player.isPlaying = true;
+            if (_inStandby == false && _progressTicks) {
                 _mediaProgress.start();
             }
-        } else if (data.value("mode").toString() == "pause" || data.value("mode").toString() == "stop") {
-            entity->setState(MediaPlayerDef::IDLE);
-            _sqPlayerDatabase[playerMac].isPlaying = false;
+        } else if (status.mode == "pause" || status.mode == "stop") {
+            state = MediaPlayerDef::IDLE;
+            player.isPlaying = false;
         }
     }
+    setEntityState(entity, state);
 
     // get track infos
-    int         playlistIndex = data.value("playlist_curr_index").toInt();
-    QVariantMap playlistItem = qvariant_cast<QVariantMap>(playlist.at(playlistIndex));
-    entity->updateAttrByIndex(MediaPlayerDef::MEDIAARTIST, playlistItem.value("artist").toString());
-    entity->updateAttrByIndex(MediaPlayerDef::MEDIATITLE, playlistItem.value("title").toString());
-    if (playlistItem.value("coverart").toBool()) {
-        entity->updateAttrByIndex(MediaPlayerDef::MEDIAIMAGE,
-                                  _httpurl + "music/" + playlistItem.value("coverid").toString() + "/cover.jpg");
+    const QVariantMap& playlistItem = status.playlistItem;
+    QString            image = coverImage(playlistItem);
+    updateEntity(entity, MediaPlayerDef::MEDIAARTIST, playlistItem.value("artist").toString());
+    updateEntity(entity, MediaPlayerDef::MEDIATITLE, playlistItem.value("title").toString());
+    updateEntity(entity, MediaPlayerDef::MEDIAIMAGE, image);
+    if (status.volume < 0) {
+        updateEntity(entity, MediaPlayerDef::MUTED, true);
     } else {
-        entity->updateAttrByIndex(MediaPlayerDef::MEDIAIMAGE, "");
+        updateEntity(entity, MediaPlayerDef::MUTED, false);
+        updateEntity(entity, MediaPlayerDef::VOLUME, status.volume);
+    }
+    player.volume = status.volume;
+    updateEntity(entity, MediaPlayerDef::MEDIADURATION, status.duration);
+
+    // the tracks around the current one are loaded with the first skip, a changed playlist invalidates them
+    double playlistTimestamp = status.playlistTimestamp > 0 ? status.playlistTimestamp : player.playlistTimestamp;
+    if (playlistTimestamp != player.playlistTimestamp) {
+        player.queue.clear();
+    }
+    player.playlistTimestamp = playlistTimestamp;
+    player.playlistIndex = status.playlistIndex;
+    player.playlistTracks = status.playlistTracks;
+    for (const QVariant& item : status.playlist) {
+        QVariantMap map = item.toMap();
+        player.queue.insert(map.value("playlist index").toInt(), map);
+    }
+    while (!player.queue.isEmpty() && player.queue.firstKey() < status.playlistIndex - 10) {
+        player.queue.erase(player.queue.begin());
+    }
+    while (!player.queue.isEmpty() && player.queue.lastKey() > status.playlistIndex + 10) {
+        player.queue.erase(player.queue.end() - 1);
+    }
+
+    QString mode = status.mode;
+    QString trackId = playlistItem.value("id").toString();
+    double  rate = state == MediaPlayerDef::PLAYING ? status.rate : 0;
+    setPlaybackPosition(playerMac, status.time, rate, trackId);
+
+    if (player.lastActivity == 0 || player.mode != mode || player.trackId != trackId) {
+        // a play is a change of the track during playback, the track id is unknown after (re)connecting
+        if (!player.trackId.isEmpty() && player.trackId != trackId && wasPlaying && player.isPlaying) {
+            _library.countPlay(trackId);
+        }
+        player.mode = mode;
+        player.trackId = trackId;
+        player.lastActivity = QDateTime::currentMSecsSinceEpoch();
+    }
+    updateNowPlaying(playerMac, state, playlistItem, image);
+
+    // command latency: from sending a command until the entity shows a status with its effect. Other statuses,
+    // like a push which was on the way already, don't count. A command without a visible effect, e.g. volume up at
+    // the maximum, is given up after 10 seconds.
+    if (player.commandSent > 0) {
+        if (player.commandConfirmed(data)) {
+            _commandLatency[player.commandTransport].add(_clock.elapsed() - player.commandSent);
+            player.commandSent = 0;
+        } else if (_clock.elapsed() - player.commandSent > 10 * 1000) {
+            player.commandSent = 0;
+        }
+    }
+
+    _parseTime.add(parseTime.nsecsElapsed() / 1000);
+}
+
+void Squeezebox::setPlaybackPosition(const QString& playerMac, double position, double rate, const QString& trackId) {
+    SqPlayer& player = _sqPlayerDatabase[playerMac];
+    qint64    now = _clock.elapsed();
+
+    // the regular status pushes only confirm the extrapolated position, they are not announced
+    double expected = player.position + player.rate * (now - player.positionTimestamp) / 1000.0;
+    bool   changed = player.positionTimestamp == 0 || rate != player.rate || trackId != player.trackId ||
+                   qAbs(expected - position) > 1.5;
+
+    player.position = position;
+    player.positionTimestamp = now;
+    player.rate = rate;
+    if (player.entity != nullptr) {
+        updateEntity(player.entity, MediaPlayerDef::MEDIAPROGRESS, position);
+    }
+
+    if (changed) {
+        emit playbackPositionChanged(playerMac, playbackPosition(playerMac));
+    }
+}
+
+QVariantMap Squeezebox::playbackPosition(const QString& entityId) const {
+    QVariantMap result;
+    auto        player = _sqPlayerDatabase.constFind(entityId);
+    if (player == _sqPlayerDatabase.constEnd()) {
+        return result;
+    }
+
+    // same time base as now()
+    result.insert("position", player->position);
+    result.insert("timestamp", _clock.msecsSinceReference() + player->positionTimestamp);
+    result.insert("rate", player->rate);
+    return result;
+}
+
+void Squeezebox::updateNowPlaying(const QString& playerMac, int state, const QVariantMap& playlistItem,
+                                  const QString& image) {
+    // only powered players with something in the playlist are listed
+    if (state == MediaPlayerDef::OFF || playlistItem.isEmpty()) {
+        _nowPlaying.remove(playerMac);
+        return;
+    }
+
+    const SqPlayer&       player = _sqPlayerDatabase[playerMac];
+    NowPlayingModel::Item item;
+    item.playerId = playerMac;
+    item.name = player.name;
+    item.state = state;
+    item.title = playlistItem.value("title").toString();
+    item.artist = playlistItem.value("artist").toString();
+    item.image = image;
+    item.lastActivity = player.lastActivity;
+    if (playlistItem.value("coverart").toBool()) {
+        item.coverId = playlistItem.value("coverid").toString();
+        item.placeholder = _placeholders.colors(item.coverId);
+        fetchPlaceholder(item.coverId);
+    }
+    _nowPlaying.update(item);
+}
+
+void Squeezebox::fetchPlaceholder(const QString& coverId) {
+    if (_placeholders.contains(coverId) || _placeholderDownloads.contains(coverId)) {
+        return;
+    }
+    _placeholderDownloads.insert(coverId);
+
+    // the server scales the cover, only a few hundred bytes are loaded and decoded
+    QNetworkReply* reply = _nam.get(QNetworkRequest(QUrl(_httpurl + "music/" + coverId + "/cover_32x32.jpg")));
+    QObject::connect(reply, &QNetworkReply::finished, this, [=]() {
+        reply->deleteLater();
+        if (reply->error() != QNetworkReply::NoError) {
+            _placeholderDownloads.remove(coverId);
+            return;
+        }
+
+        auto watcher = new QFutureWatcher<QByteArray>(this);
+        QObject::connect(watcher, &QFutureWatcher<QByteArray>::finished, this, [=]() {
+            watcher->deleteLater();
+            _placeholders.insert(coverId, watcher->result());
+
+            // an image which can't be decoded stays in the download list, so it is not loaded again
+            QStringList colors = _placeholders.colors(coverId);
+            if (!colors.isEmpty()) {
+                _placeholderDownloads.remove(coverId);
+                _nowPlaying.updatePlaceholder(coverId, colors);
+                emit artworkPlaceholderReady(coverId, colors);
+            }
+        });
+        watcher->setFuture(QtConcurrent::run(&PlaceholderTable::compute, reply->readAll()));
+    });
+}
+
+void Squeezebox::registerThumbnailProvider(QObject* item) {
+    QQmlEngine* engine = item != nullptr ? qmlEngine(item) : nullptr;
+    if (engine == nullptr) {
+        qCWarning(m_logCategory) << "No QML engine to register the thumbnail provider";
+        return;
     }
-    int volume = data.value("mixer_volume").toInt();
-    if (volume < 0) {
-        entity->updateAttrByIndex(MediaPlayerDef::MUTED, true);
+
+    // one provider per integration id, the engine takes the ownership and keeps it when the integration is recreated
+    QString            id = "squeezebox_" + integrationId().toLower();
+    ThumbnailProvider* provider = dynamic_cast<ThumbnailProvider*>(engine->imageProvider(id));
+    if (provider != nullptr) {
+        _thumbnailSource = provider->source();
+        _thumbnailSource->attach(&_thumbnails);
+    } else if (engine->imageProvider(id) == nullptr) {
+        _thumbnailSource.reset(new ThumbnailSource(&_thumbnails));
+        engine->addImageProvider(id, new ThumbnailProvider(_thumbnailSource));
     } else {
-        entity->updateAttrByIndex(MediaPlayerDef::MUTED, false);
-        entity->updateAttrByIndex(MediaPlayerDef::VOLUME, data.value("mixer_volume").toInt());
+        qCWarning(m_logCategory) << "Image provider" << id << "is taken";
+        return;
+    }
+    _thumbnailProvider = id;
+}
+
+QString Squeezebox::thumbnail(const QString& coverId, int size) const {
+    if (_thumbnailProvider.isEmpty() || !_thumbnails.contains(coverId, size)) {
+        return QString();
+    }
+    return "image://" + _thumbnailProvider + "/" + coverId + "/" + QString::number(size);
+}
+
+void Squeezebox::requestThumbnails(const QStringList& visible, const QStringList& prefetch, int size) {
+    _thumbnailFetcher.request(visible, prefetch, size);
+}
+
+QStringList Squeezebox::artworkPlaceholder(const QString& coverId) const { return _placeholders.colors(coverId); }
+
+void Squeezebox::updateEntity(EntityInterface* entity, int attrIndex, const QVariant& value) {
+    QElapsedTimer updateTime;
+    updateTime.start();
+    entity->updateAttrByIndex(attrIndex, value);
+    _entityUpdates++;
+    _entityUpdateTime.add(updateTime.nsecsElapsed() / 1000);
+}
+
+void Squeezebox::setEntityState(EntityInterface* entity, int state) {
+    QElapsedTimer updateTime;
+    updateTime.start();
+    entity->setState(state);
+    _entityUpdates++;
+    _entityUpdateTime.add(updateTime.nsecsElapsed() / 1000);
+}
+
+void Squeezebox::onPushWatchdogTimer() {
+    // subscriptions of playing players are refreshed by the server at least every 60 seconds
+    qint64 now = _clock.elapsed();
+    for (QMap<QString, SqPlayer>::iterator i = _sqPlayerDatabase.begin(); i != _sqPlayerDatabase.end(); ++i) {
+        if (i->subscribed && i->isPlaying && now - i->lastPush > 75 * 1000) {
+            i->lastPush = now;
+            recoverLostUpdate(i.key());
+        }
     }
-    entity->updateAttrByIndex(MediaPlayerDef::MEDIADURATION, data.value("duration").toInt());
+}
 
-    _sqPlayerDatabase[playerMac].position = data.value("time").toDouble();
-    entity->updateAttrByIndex(MediaPlayerDef::MEDIAPROGRESS, _sqPlayerDatabase[playerMac].position);
+void Squeezebox::recoverLostUpdate(const QString& playerMac) {
+    _lostUpdates++;
+    qCInfo(m_logCategory) << "Lost status update of" << playerMac << "- refreshing, recovered" << _lostUpdates
+                          << "time/s so far";
+    getPlayerStatus(playerMac);
 }
 
 void Squeezebox::onMediaProgressTimer() {
     bool onePlaying = false;
     for (QMap<QString, SqPlayer>::iterator i = _sqPlayerDatabase.begin(); i != _sqPlayerDatabase.end(); ++i) {
-        if (i->isPlaying) {
+        if (i->isPlaying && i->entity != nullptr) {
             onePlaying = true;
-            i->position += 0.5;
+            // derived from the last reported position, adding up timer ticks drifts away over time
+            double position = i->position + i->rate * (_clock.elapsed() - i->positionTimestamp) / 1000.0;
 
-            m_entities->getEntityInterface(i.key())->updateAttrByIndex(MediaPlayerDef::MEDIAPROGRESS, i->position);
+            updateEntity(i->entity, MediaPlayerDef::MEDIAPROGRESS, position);
         }
     }
 
@@ -378,38 +1092,39 @@ void Squeezebox::onMediaProgressTimer() {
 }
 
 void Squeezebox::socketReceived() {
-    QString     answer = _socket.readAll();
-    QStringList all = answer.split(QRegExp("[\r\n]"), QString::SkipEmptyParts);
+    QElapsedTimer receiveTime;
+    receiveTime.start();
 
-    // check if the answer is a valid http 200 response or if it is a CometD packet
-    if (!((all[0].startsWith("HTTP") && all[0].endsWith("200 OK")) || (all.size() == 2))) {
+    // a valid http 200 response or a CometD chunk
+    QByteArray document = cometdDocument(_socket.readAll());
+    if (document.isEmpty()) {
         return;
     }
 
-    QJsonParseError parseerror;
-    QByteArray      document = all[all.length() - 1].toUtf8();
-
-    QJsonDocument doc = QJsonDocument::fromJson(document, &parseerror);
-    if (parseerror.error != QJsonParseError::NoError) {
-        jsonError(parseerror.errorString());
-        return;
+    CometdBatch batch = decodeCometdBatch(document, (_subscriptionChannel + "/").toUtf8());
+    for (const QString& error : batch.errors) {
+        jsonError(error);
+    }
+    for (const QByteArray& id : batch.lostStatus) {
+        if (_sqPlayerIdMapping.contains(id.toInt())) {
+            recoverLostUpdate(_sqPlayerIdMapping.value(id.toInt()));
+        }
     }
 
-    QVariant     var = doc.toVariant();
-    QVariantList list = var.toList();
-
-    while (!list.isEmpty()) {
-        QVariantMap map = list.takeFirst().toMap();
+    for (const QVariant& received : batch.messages) {
+        QVariantMap map = received.toMap();
 
         if (_connectionState == cometdHandshake && map.value("successful").toBool() == true &&
             map.value("channel").toString() == "/meta/handshake") {
             // first step of handshake process; getting client id
+            finishStep();
             _clientId = map.value("clientId").toString().remove("\"");
             qCInfo(m_logCategory) << "Client ID: " << _clientId;
             _subscriptionChannel = "/slim/" + _clientId + "/status";
 
             _connectionState = cometdConnect;
 
+            // connect and all subscriptions go out in a single write, the replies may come in any order
             QJsonObject json = QJsonObject();
             json.insert("channel", "/meta/connect");
             json.insert("clientId", _clientId);
@@ -418,70 +1133,109 @@ void Squeezebox::socketReceived() {
             QJsonArray message = QJsonArray();
             message.append(json);
 
-            sendCometd(QJsonDocument(message).toJson());
-        } else if (_connectionState == cometdConnect && map.value("successful").toBool() == true &&
-                   map.value("channel").toString() == "/meta/connect") {
-            // now connected
-            // subscribe to player messages
-
-            _connectionState = cometdSubscribe;
-
+            _pendingSubscriptions = 0;
             for (QMap<QString, SqPlayer>::iterator i = _sqPlayerDatabase.begin(); i != _sqPlayerDatabase.end(); ++i) {
-                SqPlayer player = *i;
-                if (player.connected && !player.subscribed) {
-                    int     rand = qrand();
-                    QString command = _sqCmdPlayerStatus + " subscribe:60";
-
-                    QJsonArray request = QJsonArray();
-                    request.append(i.key());
-                    request.append(QJsonArray::fromStringList(command.split(" ")));
-
-                    QJsonObject data = QJsonObject();
-                    data.insert("response", _subscriptionChannel);
-                    data.insert("request", request);
-                    data.insert("priority", 1);
-
-                    QJsonObject json = QJsonObject();
-                    json.insert("channel", "/slim/subscribe");
-                    json.insert("clientId", _clientId);
-                    json.insert("id", rand);
-                    json.insert("data", data);
-
-                    QJsonArray complete = QJsonArray();
-                    complete.append(json);
-
-                    QByteArray message = QJsonDocument(complete).toJson();
+                if (i->connected && !i->subscribed) {
+                    message.append(subscribeMessage(i.key()));
+                }
+            }
 
-                    _sqPlayerIdMapping.insert(rand, i.key());
-                    sendCometd(message);
+            startStep();
+            sendCometd(QJsonDocument(message).toJson());
+        } else if (_connectionState == cometdConnect && map.value("channel").toString() == "/meta/connect") {
+            if (map.value("successful").toBool() != true) {
+                qCWarning(m_logCategory) << "CometD connect failed:" << map.value("error").toString();
+                _connectionState = error;
+                if (!_connectionTimeout.isActive()) {
+                    _connectionTimeout.start();
                 }
+                continue;
             }
-        } else if (_connectionState == cometdSubscribe && map.value("successful").toBool() == true &&
-                   map.value("channel").toString() == "/slim/subscribe") {
+
+            // now connected, waiting for the remaining subscriptions
+            finishStep();
+            _connectionState = cometdSubscribe;
+            if (_pendingSubscriptions == 0) {
+                sessionEstablished();
+            }
+        } else if ((_connectionState == cometdConnect || _connectionState == cometdSubscribe ||
+                    _connectionState == connectionStates::connected) &&
+                   map.value("successful").toBool() == true && map.value("channel").toString() == "/slim/subscribe") {
             QString player = _sqPlayerIdMapping.value(map["id"].toInt());
-            _sqPlayerDatabase[player].subscribed = true;
+            if (!_sqPlayerDatabase.contains(player)) {
+                // answer of an old session, operator[] would add a phantom player
+                continue;
+            }
+            if (!_sqPlayerDatabase[player].subscribed) {
+                _sqPlayerDatabase[player].subscribed = true;
+                _pendingSubscriptions--;
+            }
+            _sqPlayerDatabase[player].lastPush = _clock.elapsed();
 
-            int subscriptions = 0;
-            int connected = 0;
-            for (auto i : _sqPlayerDatabase) {
-                if (i.connected) {
-                    connected++;
-                }
-                if (i.connected && i.subscribed) {
-                    subscriptions++;
-                }
+            if (_connectionState == cometdSubscribe && _pendingSubscriptions == 0) {
+                sessionEstablished();
             }
-            if (connected == subscriptions) {
-                _connectionState = connectionStates::connected;
-                setState(CONNECTED);
+        } else if ((_connectionState == cometdConnect || _connectionState == cometdSubscribe) && _resuming &&
+                   map.value("channel").toString() == "/slim/subscribe") {
+            // a player of the cached session is gone: fall back to a full discovery
+            qCWarning(m_logCategory) << "Subscription failed while resuming, rediscovering players";
+            for (QMap<QString, SqPlayer>::iterator i = _sqPlayerDatabase.begin(); i != _sqPlayerDatabase.end();
+                 ++i) {
+                i->connected = false;
             }
-        } else if (map.value("channel").toString() == _subscriptionChannel) {
+            connect();
+            return;
+        } else if (map.value("channel").toString() == "/slim/request" && _groupRequests.contains(map["id"].toInt())) {
+            SqGroupRequest request = _groupRequests.take(map["id"].toInt());
+            groupResult(request.group, request.player, map.value("successful").toBool());
+        } else if (map.value("channel").toString() == "/slim/" + _clientId + "/request" &&
+                   _pushProbes.contains(map["id"].toInt())) {
+            auto probe = _pushProbes.take(map["id"].toInt());
+            probe.second(probe.first.elapsed());
+        } else if (map.value("channel").toString().startsWith(_subscriptionChannel + "/")) {
             QString     player = _sqPlayerIdMapping.value(map["id"].toInt());
             QVariantMap data = qvariant_cast<QVariantMap>(map.value("data"));
 
+            if (!_sqPlayerDatabase.contains(player)) {
+                continue;
+            }
+            _sqPlayerDatabase[player].lastPush = _clock.elapsed();
+
+            // playlist_timestamp never goes back: an older value means this push overtook a newer state
+            if (data.contains("playlist_timestamp") &&
+                data.value("playlist_timestamp").toDouble() < _sqPlayerDatabase[player].playlistTimestamp) {
+                recoverLostUpdate(player);
+                continue;
+            }
             parsePlayerStatus(player, data);
         }
     }
+
+    _receiveTime.add(receiveTime.nsecsElapsed() / 1000);
+}
+
+QJsonObject Squeezebox::subscribeMessage(const QString& playerMac) {
+    int     rand = qrand();
+    QString command = _sqCmdPlayerStatus + " subscribe:60";
+
+    QJsonArray request = QJsonArray();
+    request.append(playerMac);
+    request.append(QJsonArray::fromStringList(command.split(" ")));
+
+    QJsonObject data = QJsonObject();
+    data.insert("response", statusChannel(playerMac));
+    data.insert("request", request);
+    data.insert("priority", 1);
+
+    QJsonObject json = QJsonObject();
+    json.insert("channel", "/slim/subscribe");
+    json.insert("clientId", _clientId);
+    json.insert("id", rand);
+    json.insert("data", data);
+
+    _sqPlayerIdMapping.insert(rand, playerMac);
+    _pendingSubscriptions++;
+    return json;
 }
 
 void Squeezebox::sendCommand(const QString& type, const QString& entityId, int command, const QVariant& param) {
@@ -490,29 +1244,539 @@ void Squeezebox::sendCommand(const QString& type, const QString& entityId, int c
         return;
     }
 
+    if (command == MediaPlayerDef::C_NEXT) {
+        skip(entityId, 1);
+        return;
+    } else if (command == MediaPlayerDef::C_PREVIOUS) {
+        skip(entityId, -1);
+        return;
+    }
+
+    QString sqCmd = commandString(command, param);
+    if (!sqCmd.isEmpty()) {
+        sqCommand(entityId, sqCmd);
+    }
+}
+
+void Squeezebox::skip(const QString& playerMac, int tracks) {
+    QMap<QString, SqPlayer>::iterator found = _sqPlayerDatabase.find(playerMac);
+    if (found == _sqPlayerDatabase.end()) {
+        return;
+    }
+
+    // the jump is sent when no further press on this player follows within the settle window
+    found->pendingSkip += tracks;
+    found->skipDeadline = _clock.elapsed() + 300;
+    showQueuedTrack(playerMac, found->playlistIndex + found->pendingSkip);
+    if (!_skipTimer.isActive()) {
+        _skipTimer.start(300);
+    }
+
+    // a lost read does not block the next one for long
+    if (found->queue.size() <= 1 && (found->queueLoading == 0 || _clock.elapsed() - found->queueLoading > 5000)) {
+        loadQueue(playerMac);
+    }
+}
+
+void Squeezebox::loadQueue(const QString& playerMac) {
+    SqPlayer& player = _sqPlayerDatabase[playerMac];
+    player.queueLoading = _clock.elapsed();
+
+    // one read of the tracks around the current one, the status pushes only carry the current track
+    int    start = qMax(0, player.playlistIndex - 5);
+    double playlistTimestamp = player.playlistTimestamp;
+    sqRead(
+        playerMac, QStringLiteral("status %1 16 tags:acdjK").arg(start),
+        [=](const QVariantMap& results) {
+            auto found = _sqPlayerDatabase.find(playerMac);
+            if (found == _sqPlayerDatabase.end()) {
+                return;
+            }
+            found->queueLoading = 0;
+            if (results.value("playlist_timestamp", playlistTimestamp).toDouble() != found->playlistTimestamp) {
+                return;  // the playlist changed meanwhile
+            }
+
+            for (const QVariant& item : results.value("playlist_loop").toList()) {
+                QVariantMap map = item.toMap();
+                found->queue.insert(map.value("playlist index").toInt(), map);
+            }
+            if (found->pendingSkip != 0) {
+                showQueuedTrack(playerMac, found->playlistIndex + found->pendingSkip);
+            }
+        },
+       true, nullptr, true);
+}
+
+void Squeezebox::onSkipTimer() {
+    qint64 now = _clock.elapsed();
+    qint64 next = 0;
+    for (QMap<QString, SqPlayer>::iterator i = _sqPlayerDatabase.begin(); i != _sqPlayerDatabase.end(); ++i) {
+        if (i->pendingSkip == 0) {
+            continue;
+        }
+        if (i->skipDeadline > now) {
+            next = next == 0 ? i->skipDeadline : qMin(next, i->skipDeadline);
+            continue;
+        }
+        QString offset = QString::number(i->pendingSkip);
+        if (i->pendingSkip > 0) {
+            offset.prepend("+");
+        }
+        sqCommand(i.key(), "playlist index " + offset);
+
+        // optimistic, after the command kept the old index for its confirmation: the next status corrects it
+        if (i->playlistTracks > 0) {
+            i->playlistIndex = ((i->playlistIndex + i->pendingSkip) % i->playlistTracks + i->playlistTracks) %
+                               i->playlistTracks;
+        }
+        i->pendingSkip = 0;
+    }
+    if (next > 0) {
+        _skipTimer.start(static_cast<int>(next - now));
+    }
+}
+
+void Squeezebox::showQueuedTrack(const QString& playerMac, int playlistIndex) {
+    SqPlayer& player = _sqPlayerDatabase[playerMac];
+    if (player.entity == nullptr || player.playlistTracks <= 0) {
+        return;
+    }
+
+    // the server wraps around at both ends of the playlist
+    int index = ((playlistIndex % player.playlistTracks) + player.playlistTracks) % player.playlistTracks;
+    if (!player.queue.contains(index)) {
+        return;  // not in the cached window: the status push shows the track
+    }
+
+    // the status push corrects the entity if the server did something else
+    const QVariantMap& playlistItem = player.queue[index];
+    QString            image = coverImage(playlistItem);
+    updateEntity(player.entity, MediaPlayerDef::MEDIAARTIST, playlistItem.value("artist").toString());
+    updateEntity(player.entity, MediaPlayerDef::MEDIATITLE, playlistItem.value("title").toString());
+    updateEntity(player.entity, MediaPlayerDef::MEDIAIMAGE, image);
+    updateEntity(player.entity, MediaPlayerDef::MEDIADURATION, playlistItem.value("duration").toInt());
+    setPlaybackPosition(playerMac, 0, player.rate, playlistItem.value("id").toString());
+
+    int state = player.isPlaying ? MediaPlayerDef::PLAYING : MediaPlayerDef::IDLE;
+    updateNowPlaying(playerMac, state, playlistItem, image);
+}
+
+QString Squeezebox::coverImage(const QVariantMap& playlistItem) const {
+    if (playlistItem.value("coverart").toBool()) {
+        return _httpurl + "music/" + playlistItem.value("coverid").toString() + "/cover.jpg";
+    }
+
+    // remote streams (internet radio, apps) have no cover id, the server names their artwork url instead
+    QString artwork = playlistItem.value("artwork_url").toString();
+    if (artwork.isEmpty() || artwork.startsWith("http")) {
+        return artwork;
+    }
+    return _httpurl + (artwork.startsWith("/") ? artwork.mid(1) : artwork);
+}
+
+QString Squeezebox::commandString(int command, const QVariant& param) {
     if (command == MediaPlayerDef::C_PLAY) {
-        sqCommand(entityId, "play");
+        return "play";
     } else if (command == MediaPlayerDef::C_PAUSE) {
-        sqCommand(entityId, "pause 1");
+        return "pause 1";
     } else if (command == MediaPlayerDef::C_STOP) {
-        sqCommand(entityId, "stop");
+        return "stop";
     } else if (command == MediaPlayerDef::C_NEXT) {
-        sqCommand(entityId, "playlist jump +1");
+        return "playlist jump +1";
     } else if (command == MediaPlayerDef::C_PREVIOUS) {
-        sqCommand(entityId, "playlist jump -1");
+        return "playlist jump -1";
     } else if (command == MediaPlayerDef::C_TURNON) {
-        sqCommand(entityId, "power 1");
+        return "power 1";
     } else if (command == MediaPlayerDef::C_TURNOFF) {
-        sqCommand(entityId, "power 0");
+        return "power 0";
     } else if (command == MediaPlayerDef::C_MUTE) {
-        sqCommand(entityId, "mixer muting 1");
+        return "mixer muting 1";
     } else if (command == MediaPlayerDef::C_VOLUME_UP) {
-        sqCommand(entityId, "button volume_up");
+        return "button volume_up";
     } else if (command == MediaPlayerDef::C_VOLUME_DOWN) {
-        sqCommand(entityId, "button volume_down");
+        return "button volume_down";
     } else if (command == MediaPlayerDef::C_VOLUME_SET) {
-        sqCommand(entityId, "mixer volume " + param.toString());
+        return "mixer volume " + param.toString();
+    }
+    return QString();
+}
+
+void Squeezebox::allOff() { groupCommand(QStringList(), MediaPlayerDef::C_TURNOFF); }
+
+void Squeezebox::allPause() { groupCommand(QStringList(), MediaPlayerDef::C_PAUSE); }
+
+void Squeezebox::groupCommand(const QStringList& entityIds, int command, const QVariant& param) {
+    QString sqCmd = commandString(command, param);
+    if (sqCmd.isEmpty()) {
+        return;
+    }
+
+    QStringList players;
+    for (auto i = _sqPlayerDatabase.constBegin(); i != _sqPlayerDatabase.constEnd(); ++i) {
+        if (i->connected && (entityIds.isEmpty() || entityIds.contains(i.key()))) {
+            players.append(i.key());
+        }
+    }
+
+    QSharedPointer<SqGroup> group(new SqGroup());
+    group->command = command;
+    group->pending = players.size();
+    if (players.isEmpty()) {
+        emit groupCommandFinished(command, group->results);
+        return;
+    }
+
+    if (_connectionState != connectionStates::connected) {
+        // HTTP requests run in parallel on the connection pool of the network access manager
+        for (const QString& player : players) {
+            optimisticUpdate(player, command);
+            sqCommand(player, sqCmd, [=](bool success) { groupResult(group, player, success); });
+        }
+        return;
+    }
+
+    // all requests go out in a single CometD write: one round trip no matter how many players
+    QJsonArray messages = QJsonArray();
+    for (const QString& player : players) {
+        int id = qrand();
+
+        QJsonArray request = QJsonArray();
+        request.append(player);
+        request.append(QJsonArray::fromStringList(sqCmd.split(" ")));
+
+        QJsonObject data = QJsonObject();
+        data.insert("request", request);
+        data.insert("response", "/slim/" + _clientId + "/request");
+
+        QJsonObject json = QJsonObject();
+        json.insert("channel", "/slim/request");
+        json.insert("clientId", _clientId);
+        json.insert("id", id);
+        json.insert("data", data);
+        messages.append(json);
+
+        SqGroupRequest groupRequest;
+        groupRequest.group = group;
+        groupRequest.player = player;
+        _groupRequests.insert(id, groupRequest);
+
+        trackCommand(player, sqCmd, "cometd");
+        optimisticUpdate(player, command);
+    }
+    sendCometd(QJsonDocument(messages).toJson());
+
+    // players without acknowledgement count as failed
+    QTimer::singleShot(5 * 1000, this, [=]() {
+        for (auto i = _groupRequests.begin(); i != _groupRequests.end();) {
+            if (i->group == group) {
+                groupResult(group, i->player, false);
+                i = _groupRequests.erase(i);
+            } else {
+                ++i;
+            }
+        }
+    });
+}
+
+void Squeezebox::groupResult(const QSharedPointer<SqGroup>& group, const QString& playerMac, bool success) {
+    if (group->results.contains(playerMac)) {
+        return;
+    }
+    group->results.insert(playerMac, success);
+    if (--group->pending == 0) {
+        emit groupCommandFinished(group->command, group->results);
+    }
+}
+
+void Squeezebox::optimisticUpdate(const QString& playerMac, int command) {
+    SqPlayer& player = _sqPlayerDatabase[playerMac];
+    if (player.entity == nullptr) {
+        return;
+    }
+
+    // the status push corrects the entity if the server did something else
+    if (command == MediaPlayerDef::C_TURNOFF) {
+        player.isPlaying = false;
+        setEntityState(player.entity, MediaPlayerDef::OFF);
+        _nowPlaying.remove(playerMac);
+    } else if (command == MediaPlayerDef::C_PAUSE && player.isPlaying) {
+        player.isPlaying = false;
+        setEntityState(player.entity, MediaPlayerDef::IDLE);
+        double position = player.position + player.rate * (_clock.elapsed() - player.positionTimestamp) / 1000.0;
+        setPlaybackPosition(playerMac, position, 0, player.trackId);
+    }
+}
+
+void Squeezebox::getTrackInfo(const QString& entityId, const QString& trackId) {
+    QString id = trackId;
+    if (id.isEmpty() && _sqPlayerDatabase.contains(entityId)) {
+        id = _sqPlayerDatabase[entityId].trackId;
+    }
+    if (id.isEmpty()) {
+        emit trackInfo(entityId, id, QVariantMap());
+        return;
+    }
+
+    if (_trackInfoCache.contains(id)) {
+        emit trackInfo(entityId, id, *_trackInfoCache.object(id));
+        return;
+    }
+
+    // songinfo returns every tag as a separate loop item
+    QSharedPointer<QVariantMap> info(new QVariantMap());
+    sqReadStream(
+        entityId, "songinfo 0 100 track_id:" + id + " tags:aAlygrTIodtiqcu",
+        [=](const QString&, const QVariantMap& item) {
+            for (auto i = item.constBegin(); i != item.constEnd(); ++i) {
+                info->insert(i.key(), i.value());
+            }
+        },
+        [=](const QVariantMap&) {
+            _trackInfoCache.insert(id, new QVariantMap(*info));
+            emit trackInfo(entityId, id, *info);
+        },
+        [=]() { emit trackInfo(entityId, id, QVariantMap()); }, true);
+}
+
+QVariantList Squeezebox::librarySearch(const QString& query, int limit) const {
+    return _library.search(query, limit);
+}
+
+void Squeezebox::updateLibraryIndex() {
+    if (_libraryUpdating) {
+        return;
+    }
+    _libraryUpdating = true;
+
+    // the index is only rebuilt after the server rescanned the library
+    int build = _libraryBuild;
+    sqRead(
+        "-", "serverstatus 0 0",
+        [=](const QVariantMap& status) {
+            QString scanId = status.value("lastscan").toString();
+            if (build != _libraryBuild || (scanId == _library.scanId() && _library.count() > 0)) {
+                libraryBuildEnded(build, false);
+                return;
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+            _library.clear();
+            sqReadStream(
+                "-", "titles 0 1000000 tags:aels",
+                [=](const QString& loop, const QVariantMap& track) {
+                    // a stale build must not add to the index of the next one
+                    if (loop == "titles_loop" && build == _libraryBuild) {
+                        _library.addTrack(track);
+                    }
+                },
+                [=](const QVariantMap&) {
+                    if (build == _libraryBuild) {
+                        _library.finish(scanId);
+                        qCInfo(m_logCategory) << "Library index with" << _library.count() << "names built in"
+                                              << timer.elapsed() << "ms";
+                    }
+                    libraryBuildEnded(build, build != _libraryBuild);
+                },
+                [=]() { libraryBuildEnded(build, true); });
+        },
+        false, [=]() { libraryBuildEnded(build, false); });
+}
+
+void Squeezebox::libraryBuildEnded(int build, bool partial) {
+    _libraryUpdating = false;
+
+    // a partial index is neither searched nor saved, the next session builds it again
+    if (partial) {
+        _library.clear();
+    }
+    if (build != _libraryBuild && _socket.state() == QAbstractSocket::ConnectedState) {
+        updateLibraryIndex();
+    }
+}
+
+void Squeezebox::browse(const QString& menu, const QString& itemId, int start, int count) {
+    _browseCache.countUse(menu);
+    browsePage(menu, itemId, start, count, true);
+}
+
+void Squeezebox::browsePage(const QString& menu, const QString& itemId, int start, int count, bool notify) {
+    QString     key = QStringLiteral("%1|%2|%3|%4").arg(menu, itemId).arg(start).arg(count);
+    QVariantMap page;
+    if (_browseCache.lookup(key, &page)) {
+        if (notify) {
+            emit browseResult(menu, itemId, start, page);
+        }
+        return;
+    }
+
+    // top level menus list the radio and app services, their content is paged with "items"
+    bool    topLevel = menu == "radios" || menu == "apps";
+    QString command = topLevel ? QStringLiteral("%1 %2 %3").arg(menu).arg(start).arg(count)
+                               : QStringLiteral("%1 items %2 %3").arg(menu).arg(start).arg(count);
+    if (!itemId.isEmpty()) {
+        command += " item_id:" + itemId;
+    }
+
+    // a page is small and is read as a whole, so a late answer can be hedged
+    sqRead(
+        browsePlayer(), command,
+        [=](const QVariantMap& results) {
+            QVariantList items;
+            for (auto i = results.constBegin(); i != results.constEnd(); ++i) {
+                if (i.key().endsWith("_loop")) {
+                    for (const QVariant& item : i.value().toList()) {
+                        items.append(browseItem(item.toMap()));
+                    }
+                }
+            }
+
+            QVariantMap page;
+            page.insert("title", results.value("title"));
+            page.insert("count", results.value("count").toInt());
+            page.insert("items", items);
+
+            _browseCache.insert(key, page, topLevel ? BrowseCache::SERVICE_TTL : BrowseCache::ITEM_TTL);
+            if (notify) {
+                emit browseResult(menu, itemId, start, page);
+            }
+        },
+        false, nullptr, true);
+}
+
+void Squeezebox::prefetchMenus() {
+    // first page of the entry points and the most used menus, so opening them needs no round trip
+    QStringList menus({"radios", "apps"});
+    for (const QString& menu : _browseCache.mostUsed(3)) {
+        if (!menus.contains(menu)) {
+            menus.append(menu);
+        }
+    }
+    for (const QString& menu : menus) {
+        browsePage(menu, QString(), 0, 50, false);
+    }
+}
+
+QVariantMap Squeezebox::browseItem(const QVariantMap& item) {
+    QVariantMap result = item;
+    QString     icon = item.contains("icon") ? item.value("icon").toString() : item.value("image").toString();
+    if (icon.isEmpty()) {
+        return result;
+    }
+
+    if (!icon.startsWith("http")) {
+        icon = _httpurl + (icon.startsWith("/") ? icon.mid(1) : icon);
+    }
+
+    QString cached = _browseCache.cachedIcon(icon);
+    if (cached.isEmpty()) {
+        fetchIcon(icon);
+        result.insert("icon", icon);
+    } else {
+        result.insert("icon", cached);
     }
+    return result;
+}
+
+QString Squeezebox::browsePlayer() const {
+    // apps need a player context, e.g. for the account of a streaming service
+    for (auto i = _sqPlayerDatabase.constBegin(); i != _sqPlayerDatabase.constEnd(); ++i) {
+        if (i->connected) {
+            return i.key();
+        }
+    }
+    return "-";
+}
+
+void Squeezebox::fetchIcon(const QString& url) {
+    if (_iconDownloads.contains(url)) {
+        return;
+    }
+    _iconDownloads.insert(url);
+
+    QNetworkReply* reply = _nam.get(QNetworkRequest(QUrl(url)));
+    QObject::connect(reply, &QNetworkReply::finished, this, [=]() {
+        reply->deleteLater();
+        _iconDownloads.remove(url);
+
+        if (reply->error() == QNetworkReply::NoError) {
+            _browseCache.storeIcon(url, reply->readAll());
+        }
+    });
+}
+
+void Squeezebox::runDiagnostics() {
+    if (_diagnostics == nullptr) {
+        _diagnostics = new LinkDiagnostics(&_nam, _url, _port, buildRpcRequest(),
+                                           [=](const std::function<void(qint64)>& done) { pushProbe(done); }, this);
+        QObject::connect(_diagnostics, &LinkDiagnostics::finished, this, [=](const QVariantMap& report) {
+            QVariantMap complete = report;
+            complete.insert("performance", performance());
+            complete.insert("commandLatency", commandLatency());
+            emit diagnosticsFinished(complete);
+        });
+    }
+    _diagnostics->start();
+}
+
+void Squeezebox::pushProbe(const std::function<void(qint64)>& done) {
+    if (_connectionState != connectionStates::connected) {
+        done(-1);
+        return;
+    }
+
+    // the answer to a request with response channel is pushed through the CometD connection
+    int         id = qrand();
+    QJsonArray  request = QJsonArray();
+    QJsonObject data = QJsonObject();
+    QJsonObject json = QJsonObject();
+    request.append("-");
+    request.append(QJsonArray::fromStringList({"version", "?"}));
+    data.insert("request", request);
+    data.insert("response", "/slim/" + _clientId + "/request");
+    json.insert("channel", "/slim/request");
+    json.insert("clientId", _clientId);
+    json.insert("id", id);
+    json.insert("data", data);
+
+    QElapsedTimer timer;
+    timer.start();
+    _pushProbes.insert(id, qMakePair(timer, done));
+    sendCometd(QJsonDocument(QJsonArray({json})).toJson());
+
+    // forget probes that never get an answer
+    QTimer::singleShot(10 * 1000, this, [=]() { _pushProbes.remove(id); });
+}
+
+QVariantMap Squeezebox::commandLatency() const {
+    QVariantMap result;
+    for (auto i = _commandLatency.constBegin(); i != _commandLatency.constEnd(); ++i) {
+        result.insert(i.key(), i->toMap());
+    }
+    return result;
+}
+
+QVariantMap Squeezebox::performance() const {
+    QVariantMap result;
+    result.insert("players", _sqPlayerDatabase.size());
+    result.insert("subscriptions", _sqPlayerIdMapping.size());
+    result.insert("handshakeMs", _handshakeDuration);
+    result.insert("wakeMs", _wakeTime.toMap());
+    result.insert("receiveUs", _receiveTime.toMap());
+    result.insert("parseStatusUs", _parseTime.toMap());
+    result.insert("readMs", _readLatency.toMap());
+    result.insert("lostUpdates", _lostUpdates);
+    result.insert("entityUpdates", _entityUpdates);
+    result.insert("entityUpdateUs", _entityUpdateTime.toMap());
+    result.insert("timeoutMs", _rtt.toMap());
+
+    QVariantMap thumbnails;
+    thumbnails.insert("count", _thumbnails.count());
+    thumbnails.insert("liveBytes", _thumbnails.liveBytes());
+    thumbnails.insert("fileBytes", _thumbnails.fileBytes());
+    result.insert("thumbnails", thumbnails);
+    return result;
 }
 
 void Squeezebox::jsonError(const QString& error) { qCWarning(m_logCategory) << "JSON error " << error; }
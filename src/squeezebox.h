@@ -22,20 +22,37 @@
 
 #pragma once
 
+#include <QCache>
 #include <QColor>
+#include <QElapsedTimer>
 #include <QJsonObject>
 #include <QLoggingCategory>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QObject>
+#include <QSet>
+#include <QSharedPointer>
 #include <QString>
 #include <QTimer>
 #include <QVariant>
+#include <functional>
 
 #include "yio-interface/entities/mediaplayerinterface.h"
 #include "yio-plugin/integration.h"
 #include "yio-plugin/plugin.h"
 
+#include "browsecache.h"
+#include "jsonstreamreader.h"
+#include "latencystats.h"
+#include "libraryindex.h"
+#include "linkdiagnostics.h"
+#include "nowplayingmodel.h"
+#include "placeholdertable.h"
+#include "rttestimator.h"
+#include "thumbnailfetcher.h"
+#include "thumbnailprovider.h"
+#include "thumbnailstore.h"
+
 const bool NO_WORKER_THREAD = false;
 
 class SqueezeboxPlugin : public Plugin {
@@ -55,13 +72,85 @@ class SqueezeboxPlugin : public Plugin {
 
 class Squeezebox : public Integration {
     Q_OBJECT
+    Q_PROPERTY(QObject* nowPlaying READ nowPlaying CONSTANT)
 
  public:
     explicit Squeezebox(const QVariantMap& config, EntitiesInterface* entities, NotificationsInterface* notifications,
                         YioAPIInterface* api, ConfigInterface* configObj, Plugin* plugin);
+    ~Squeezebox() override;
 
     void sendCommand(const QString& type, const QString& entityId, int command, const QVariant& param) override;
 
+    QObject* nowPlaying() { return &_nowPlaying; }
+
+    // latency of the recent commands per transport in ms: count, p50, p99 and max
+    Q_INVOKABLE QVariantMap commandLatency() const;
+
+    // handshake duration, time spent on the UI thread per received message, status and entity update, read latencies
+    // and the current request timeout
+    Q_INVOKABLE QVariantMap performance() const;
+
+    // Browse the internet radio and apps menus. Top level menus are "radios" and "apps", their items name the
+    // menu ("cmd") and the item id to browse further. The page is delivered with browseResult().
+    Q_INVOKABLE void browse(const QString& menu, const QString& itemId = QString(), int start = 0, int count = 50);
+
+    // Details of a track (album, year, genre, bitrate, ...) for the detail view. Without a track id the current
+    // track of the player is used. The result is delivered with trackInfo() and cached per track id. It is empty
+    // when there is no track or the server doesn't answer in time.
+    Q_INVOKABLE void getTrackInfo(const QString& entityId, const QString& trackId = QString());
+
+    // Scenes: one command to many players at once, all players if the list is empty. Over CometD all requests go
+    // out in a single write. The entities are updated optimistically, groupCommandFinished() reports per player.
+    Q_INVOKABLE void groupCommand(const QStringList& entityIds, int command, const QVariant& param = QVariant());
+    Q_INVOKABLE void allOff();
+    Q_INVOKABLE void allPause();
+
+    // Measure the link to the server: TCP connect, JSON-RPC round trips, CometD push latency and throughput.
+    // Takes a few seconds, the report is delivered with diagnosticsFinished().
+    Q_INVOKABLE void runDiagnostics();
+
+    // Picks up player entities added or removed at runtime: only the difference is subscribed or unsubscribed.
+    // Also done on every connect.
+    Q_INVOKABLE void refreshEntities();
+
+    // Position in seconds at a monotonic timestamp (msecs, time base of now()) and the playback rate, so the UI can
+    // animate the progress bar itself: position + rate * (now() - timestamp) / 1000. playbackPositionChanged() is
+    // only emitted on seeks, pauses and track changes. With "progressTicks" off this is the only moving position,
+    // MEDIAPROGRESS then changes with the status updates only.
+    Q_INVOKABLE QVariantMap playbackPosition(const QString& entityId) const;
+
+    // Current time in msecs of the monotonic clock of the timestamps.
+    Q_INVOKABLE qint64 now() const { return _clock.msecsSinceReference() + _clock.elapsed(); }
+
+    // 4x4 colors ("#rrggbb", row by row) to paint while the cover art is loading, empty if not computed yet.
+    // The now playing model carries them as "placeholder", new ones are announced with artworkPlaceholderReady().
+    Q_INVOKABLE QStringList artworkPlaceholder(const QString& coverId) const;
+
+    // Adds the image provider of the stored thumbnails to the QML engine of the item, call it once before
+    // thumbnail(). The provider reads straight from the mapped thumbnail file.
+    Q_INVOKABLE void registerThumbnailProvider(QObject* item);
+
+    // Stored grid thumbnail (size x size pixels) as image url for an Image, empty if it is not stored or the
+    // provider is not registered.
+    Q_INVOKABLE QString thumbnail(const QString& coverId, int size) const;
+
+    // Covers the grid shows and a margin around them to load into the store, replaces the last call. Visible ones
+    // come first, the rest is cancelled. Each stored thumbnail is announced with thumbnailReady().
+    Q_INVOKABLE void requestThumbnails(const QStringList& visible, const QStringList& prefetch, int size);
+
+    // Search artists, albums and tracks in the local index of the library, typing errors are tolerated. Each result
+    // has type ("artist", "album" or "track"), id, name, artist, distance and popularity, best match first.
+    Q_INVOKABLE QVariantList librarySearch(const QString& query, int limit = 20) const;
+
+ signals:
+    void diagnosticsFinished(const QVariantMap& report);
+    void playbackPositionChanged(const QString& entityId, const QVariantMap& position);
+    void artworkPlaceholderReady(const QString& coverId, const QStringList& colors);
+    void thumbnailReady(const QString& coverId, int size);
+    void groupCommandFinished(int command, const QVariantMap& results);  // key: entity id, value: success
+    void trackInfo(const QString& entityId, const QString& trackId, const QVariantMap& info);
+    void browseResult(const QString& menu, const QString& itemId, int start, const QVariantMap& page);
+
  private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
     void connect() override;
     void disconnect() override;
@@ -76,26 +165,123 @@ class Squeezebox : public Integration {
     void networkError(QNetworkReply::NetworkError code);
     void onMediaProgressTimer();
     void onConnectionTimeoutTimer();
+    void onPushWatchdogTimer();
+    void onWakePollTimer();
+    void onSkipTimer();
 
  private:
+    typedef std::function<bool(const QVariantMap& status)> CommandCheck;
+
     struct SqPlayer {
         SqPlayer() {}
-        bool   connected = false;
-        bool   subscribed = false;
-        bool   isPlaying = false;
-        double position = 0;
+        EntityInterface*       entity = nullptr;
+        bool                   connected = false;
+        bool                   subscribed = false;
+        bool                   isPlaying = false;
+        double                 position = 0;
+        qint64                 positionTimestamp = 0;  // _clock time of position
+        double                 rate = 0;               // playback rate, 0 when not playing
+        QString                name;
+        QString                mode;
+        QString                trackId;
+        qint64                 lastActivity = 0;
+        qint64                 lastPush = 0;  // _clock time of the last subscription message
+        double                 playlistTimestamp = 0;
+        qint64                 commandSent = 0;  // _clock time of the last unconfirmed command
+        QString                commandTransport;
+        CommandCheck           commandConfirmed;  // true for the status showing the effect of the command
+        int                    volume = 0;        // "mixer volume" of the last status, negative when muted
+        int                    playlistIndex = 0;
+        int                    playlistTracks = 0;
+        QMap<int, QVariantMap> queue;             // key: playlist index, tracks around the current one
+        qint64                 queueLoading = 0;  // _clock time of the pending queue read
+        int                    pendingSkip = 0;   // coalesced next/previous presses not sent yet
+        qint64                 skipDeadline = 0;  // _clock time the pending presses are sent at
+    };
+    // idempotent read which may be sent a second time (hedged) if the first reply is late
+    struct SqRead {
+        QByteArray                              json;
+        std::function<void(const QVariantMap&)> callback;
+        QSharedPointer<JsonStreamReader>        reader;  // set for streamed reads
+        QList<QNetworkReply*>                   replies;
+        QNetworkReply*                          winner = nullptr;
+        QElapsedTimer                           timer;
+        qint64                                  hedgeSent = 0;
+        bool                                    timed = false;      // aborted without an answer within the timeout
+        std::function<void()>                   failed;             // optional, network and JSON errors
+        bool                                    hedgeable = false;  // small idempotent status and browse reads
+    };
+    // scene command fanned out to several players
+    struct SqGroup {
+        int         command = 0;
+        int         pending = 0;
+        QVariantMap results;  // key: player mac, value: success
     };
-    const QString _sqCmdPlayerStatus = "status - 1 tags:aBcdgjKlNotuxyY power";
+    struct SqGroupRequest {
+        QSharedPointer<SqGroup> group;
+        QString                 player;
+    };
+    // only what the player entity shows, details are fetched on demand with getTrackInfo()
+    const QString _sqCmdPlayerStatus = "status - 1 tags:acdjK power";
 
     void getPlayers();
+    void addPlayer(const QString& playerMac, EntityInterface* entity);
+    void removePlayer(const QString& playerMac);
+    void connectSocket();
+    void closeSession();
+    void sessionEstablished();
+    void wakeServer();
+    void sendMagicPacket();
+    void resume();
     void jsonError(const QString& error);
     void sendCometd(const QByteArray& message);
-    void sqCommand(const QString& playerMac, const QString& command);
+    void sqCommand(const QString& playerMac, const QString& command, const std::function<void(bool)>& done = nullptr);
+    void trackCommand(const QString& playerMac, const QString& command, const QString& transport);
+    void sqRead(const QString& playerMac, const QString& command,
+                const std::function<void(const QVariantMap&)>& callback, bool timed = false,
+                const std::function<void()>& failed = nullptr, bool hedgeable = false);
+    void sqReadStream(const QString& playerMac, const QString& command, const JsonStreamReader::ItemCallback& items,
+                      const std::function<void(const QVariantMap&)>& callback,
+                      const std::function<void()>& failed = nullptr, bool timed = false);
+    void startRead(const QSharedPointer<SqRead>& read);
+    void postRead(const QSharedPointer<SqRead>& read);
+    void hedgeRead(const QSharedPointer<SqRead>& read);
+    bool selectReadWinner(const QSharedPointer<SqRead>& read, QNetworkReply* reply);
+    int  hedgeDelay() const;
+    void startStep();
+    void finishStep();
+    void timeoutRequest(QNetworkReply* reply);
     void getPlayerStatus(const QString& playerMac);
     void parsePlayerStatus(const QString& playerMac, const QVariantMap& data);
+    void recoverLostUpdate(const QString& playerMac);
+    void updateNowPlaying(const QString& playerMac, int state, const QVariantMap& playlistItem, const QString& image);
+    void setPlaybackPosition(const QString& playerMac, double position, double rate, const QString& trackId);
+    // all entity updates go through here, so the cost of the UI side is part of performance()
+    void updateEntity(EntityInterface* entity, int attrIndex, const QVariant& value);
+    void setEntityState(EntityInterface* entity, int state);
+
+    void        browsePage(const QString& menu, const QString& itemId, int start, int count, bool notify);
+    void        prefetchMenus();
+    QVariantMap browseItem(const QVariantMap& item);
+    QString     browsePlayer() const;
+    void        fetchIcon(const QString& url);
+    void        fetchPlaceholder(const QString& coverId);
+    void        updateLibraryIndex();
+    void        libraryBuildEnded(int build, bool partial);
+
+    QString commandString(int command, const QVariant& param);
+    void    groupResult(const QSharedPointer<SqGroup>& group, const QString& playerMac, bool success);
+    void    optimisticUpdate(const QString& playerMac, int command);
+    void    skip(const QString& playerMac, int tracks);
+    void    loadQueue(const QString& playerMac);
+    void    showQueuedTrack(const QString& playerMac, int playlistIndex);
+    QString coverImage(const QVariantMap& playlistItem) const;
+    void    pushProbe(const std::function<void(qint64)>& done);
 
     QByteArray      buildRpcJson(int id, const QString& player, const QString& command);
     QNetworkRequest buildRpcRequest();
+    QJsonObject     subscribeMessage(const QString& playerMac);
+    QString         statusChannel(const QString& playerMac) const;
 
  private:
     enum connectionStates {
@@ -116,12 +302,67 @@ class Squeezebox : public Integration {
     QTimer                  _connectionTimeout;
     int                     _connectionTries;
     bool                    _userDisconnect;
+    bool                    _discovered;
+    bool                    _resumeOnNetwork;
+    bool                    _resuming;
+    QElapsedTimer           _resumeTimer;
+    QElapsedTimer           _clock;  // monotonic time base
+    QString                 _mac;    // Wake-on-LAN address of the server
+    bool                    _waking;
+    QElapsedTimer           _wakeTimer;
+    QTimer                  _wakePoll;
+    int                     _wakeDelay;
+    qint64                  _wakePacketSent;
+    LatencyStats            _wakeTime;  // milliseconds from the first magic packet until connected
     QTimer                  _mediaProgress;
+    bool                    _progressTicks;  // MEDIAPROGRESS every 500 ms while playing
+    QTimer                  _pushWatchdog;
+    int                     _lostUpdates;
     QString                 _clientId;
     int                     _playerCnt;
     QString                 _subscriptionChannel;
     QMap<QString, SqPlayer> _sqPlayerDatabase;   // key: player mac, value: player infos
     QMap<int, QString>      _sqPlayerIdMapping;  // key: subscription id, value: player mac
+    QMap<QString, QString>  _serverPlayers;      // key: player mac, value: name of all players of the server
     QList<EntityInterface*> _myEntities;
     bool                    _inStandby;
+    NowPlayingModel         _nowPlaying;
+    bool                    _hedging;
+    double                  _hedgeBudget;
+    LatencyStats            _readLatency;  // milliseconds
+
+    QMap<QString, LatencyStats> _commandLatency;  // key: transport, milliseconds
+
+    int           _pendingSubscriptions;
+    QElapsedTimer _handshakeTimer;
+    qint64        _handshakeDuration;
+    LatencyStats  _receiveTime;  // microseconds
+    LatencyStats  _parseTime;    // microseconds
+    int           _entityUpdates;
+    LatencyStats  _entityUpdateTime;  // microseconds
+
+    BrowseCache   _browseCache;
+    QSet<QString> _iconDownloads;
+
+    QCache<QString, QVariantMap> _trackInfoCache;  // key: track id
+    QHash<int, SqGroupRequest>   _groupRequests;   // key: CometD message id
+    QTimer                       _skipTimer;       // earliest skip deadline of all players
+
+    LinkDiagnostics*                                              _diagnostics;
+    QHash<int, QPair<QElapsedTimer, std::function<void(qint64)>>> _pushProbes;  // key: CometD message id
+
+    RttEstimator  _rtt;
+    QElapsedTimer _stepTimer;  // current handshake step
+
+    PlaceholderTable _placeholders;
+    QSet<QString>    _placeholderDownloads;  // key: cover id
+
+    ThumbnailStore                  _thumbnails;
+    ThumbnailFetcher                _thumbnailFetcher;
+    QString                         _thumbnailProvider;  // id of the image provider, empty until registered
+    QSharedPointer<ThumbnailSource> _thumbnailSource;    // shared with the provider, released before _thumbnails
+
+    LibraryIndex _library;
+    bool         _libraryUpdating;  // until the titles read of the build finished or failed
+    int          _libraryBuild;     // a new session makes the running build stale
 };
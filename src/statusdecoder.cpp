@@ -0,0 +1,114 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "statusdecoder.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QSet>
+
+#include "cometdscanner.h"
+
+QByteArray cometdDocument(const QByteArray& read) {
+    // only the first and the last non-empty line and their number matter
+    QByteArray first;
+    QByteArray last;
+    int        lines = 0;
+    int        start = 0;
+    for (int i = 0; i <= read.size(); ++i) {
+        if (i < read.size() && read.at(i) != '\r' && read.at(i) != '\n') {
+            continue;
+        }
+        if (i > start) {
+            last = read.mid(start, i - start);
+            if (lines++ == 0) {
+                first = last;
+            }
+        }
+        start = i + 1;
+    }
+
+    if (lines == 0 || !((first.startsWith("HTTP") && first.endsWith("200 OK")) || lines == 2)) {
+        return QByteArray();
+    }
+    return last;
+}
+
+CometdBatch decodeCometdBatch(const QByteArray& document, const QByteArray& statusPrefix) {
+    CometdBatch            batch;
+    QVector<CometdMessage> messages = CometdScanner::scan(document);
+    QSet<QByteArray>       statusIds;
+
+    // a burst may carry several status messages of the same player: only the latest one is decoded
+    for (int i = messages.size() - 1; i >= 0; --i) {
+        const CometdMessage& message = messages.at(i);
+        bool                 status = message.channel.startsWith(statusPrefix);
+        if (status && !message.id.isEmpty()) {
+            if (statusIds.contains(message.id)) {
+                continue;
+            }
+            statusIds.insert(message.id);
+        }
+
+        QJsonParseError parseerror;
+        QJsonDocument   doc =
+            QJsonDocument::fromJson(document.mid(message.begin, message.end - message.begin), &parseerror);
+        if (parseerror.error != QJsonParseError::NoError) {
+            // the scanner still knows whose status got lost
+            batch.errors.append(parseerror.errorString());
+            if (status) {
+                batch.lostStatus.append(message.id);
+            }
+            continue;
+        }
+        batch.messages.prepend(doc.object().toVariantMap());
+    }
+    return batch;
+}
+
+PlayerStatus decodePlayerStatus(const QVariantMap& data) {
+    PlayerStatus status;
+    status.power = data.value("power").toBool();
+    status.mode = data.value("mode").toString();
+    status.volume = data.value("mixer volume").toInt();
+    status.duration = data.value("duration").toInt();
+    status.time = data.value("time").toDouble();
+    status.rate = data.value("rate", 1).toDouble();
+    status.playlistIndex = data.value("playlist_cur_index").toInt();
+    status.playlistTracks = data.value("playlist_tracks").toInt();
+    status.playlistTimestamp = data.value("playlist_timestamp").toDouble();
+    status.playlist = data.value("playlist_loop").toList();
+
+    // the playlist window starts at the current track, its items carry their absolute "playlist index"
+    for (const QVariant& item : status.playlist) {
+        QVariantMap map = item.toMap();
+        if (map.value("playlist index").toInt() == status.playlistIndex) {
+            status.playlistItem = map;
+            break;
+        }
+    }
+    if (status.playlistItem.isEmpty() && !status.playlist.isEmpty()) {
+        status.playlistItem = status.playlist.first().toMap();
+    }
+    return status;
+}
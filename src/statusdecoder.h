@@ -0,0 +1,63 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QVector>
+
+// Framing and decoding of the CometD stream without any state of the integration, so the stages which see the raw
+// server traffic can be fuzzed on their own. Squeezebox::socketReceived() and parsePlayerStatus() are built on them.
+
+// JSON document of one read of the CometD socket: a read is the response header followed by the first chunk, or a
+// chunk of its size line and the message array. Empty for any other read.
+QByteArray cometdDocument(const QByteArray& read);
+
+struct CometdBatch {
+    QVariantList        messages;    // oldest first, only the latest status of each subscription
+    QStringList         errors;      // of the messages which are not valid JSON
+    QVector<QByteArray> lostStatus;  // subscription ids of the status messages among them
+};
+
+// decodes the messages of a document, the status messages are the ones on channels starting with statusPrefix
+CometdBatch decodeCometdBatch(const QByteArray& document, const QByteArray& statusPrefix);
+
+// what the player entity shows of a status
+struct PlayerStatus {
+    bool         power = false;
+    QString      mode;
+    int          volume = 0;  // negative when muted
+    int          duration = 0;
+    double       time = 0;  // seconds into the track
+    double       rate = 1;
+    int          playlistIndex = 0;
+    int          playlistTracks = 0;
+    double       playlistTimestamp = 0;  // 0 when the status doesn't carry it
+    QVariantList playlist;               // window starting at the current track
+    QVariantMap  playlistItem;           // current track, empty for an empty playlist
+};
+
+PlayerStatus decodePlayerStatus(const QVariantMap& data);
@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "thumbnailfetcher.h"
+
+#include <QNetworkRequest>
+#include <QSet>
+#include <QUrl>
+
+ThumbnailFetcher::ThumbnailFetcher(QNetworkAccessManager* nam, ThumbnailStore* store, QObject* parent)
+    : QObject(parent), _nam(nam), _store(store) {}
+
+void ThumbnailFetcher::request(const QStringList& visible, const QStringList& prefetch, int size) {
+    QList<Fetch>  queue;
+    QSet<QString> wanted;
+    for (int i = 0; i < visible.size() + prefetch.size(); ++i) {
+        Fetch fetch;
+        fetch.visible = i < visible.size();
+        fetch.coverId = fetch.visible ? visible.at(i) : prefetch.at(i - visible.size());
+        fetch.size = size;
+
+        QString name = key(fetch.coverId, size);
+        if (fetch.coverId.isEmpty() || wanted.contains(name)) {
+            continue;
+        }
+        wanted.insert(name);
+        if (!_running.contains(name) && !_store->contains(fetch.coverId, size)) {
+            queue.append(fetch);
+        }
+    }
+
+    // covers which scrolled away before they arrived are not loaded any more
+    for (auto i = _running.begin(); i != _running.end();) {
+        if (wanted.contains(i.key())) {
+            ++i;
+            continue;
+        }
+        QNetworkReply* reply = i.value();
+        i = _running.erase(i);
+        QObject::disconnect(reply, nullptr, this, nullptr);
+        reply->abort();
+        reply->deleteLater();
+    }
+
+    _queue = queue;
+    startNext();
+}
+
+void ThumbnailFetcher::cancel() { request(QStringList(), QStringList(), 0); }
+
+void ThumbnailFetcher::startNext() {
+    while (_running.size() < MAX_RUNNING && !_queue.isEmpty()) {
+        Fetch   fetch = _queue.takeFirst();
+        QString name = key(fetch.coverId, fetch.size);
+        QString size = QString::number(fetch.size);
+
+        // the server scales and caches the cover
+        QNetworkRequest request(QUrl(_httpUrl + "music/" + fetch.coverId + "/cover_" + size + "x" + size + ".jpg"));
+        request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
+        request.setPriority(fetch.visible ? QNetworkRequest::HighPriority : QNetworkRequest::LowPriority);
+
+        QNetworkReply* reply = _nam->get(request);
+        _running.insert(name, reply);
+        QObject::connect(reply, &QNetworkReply::finished, this, [=]() {
+            reply->deleteLater();
+            _running.remove(name);
+
+            // a thumbnail which did not make it into the store would show an empty image
+            if (reply->error() == QNetworkReply::NoError &&
+                _store->insert(fetch.coverId, fetch.size, reply->readAll())) {
+                emit thumbnailReady(fetch.coverId, fetch.size);
+            }
+            startNext();
+        });
+    }
+}
@@ -0,0 +1,73 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include "thumbnailstore.h"
+
+// Loads the thumbnails of an album grid into the thumbnail store. Only the visible covers and a prefetch margin
+// around them are wanted: the visible ones are requested first, covers which scroll away are cancelled. The
+// requests are pipelined over the keep-alive connections of the network access manager.
+class ThumbnailFetcher : public QObject {
+    Q_OBJECT
+
+ public:
+    ThumbnailFetcher(QNetworkAccessManager* nam, ThumbnailStore* store, QObject* parent = nullptr);
+
+    void setServer(const QString& httpUrl) { _httpUrl = httpUrl; }
+
+    // replaces the wanted covers of the last call
+    void request(const QStringList& visible, const QStringList& prefetch, int size);
+    void cancel();
+
+    int pending() const { return _queue.size() + _running.size(); }
+
+ signals:
+    void thumbnailReady(const QString& coverId, int size);
+
+ private:
+    struct Fetch {
+        QString coverId;
+        int     size = 0;
+        bool    visible = false;
+    };
+
+    static const int MAX_RUNNING = 8;  // spread over the connections of the host, so each one has a request queued
+
+    static QString key(const QString& coverId, int size) { return coverId + "@" + QString::number(size); }
+
+    void startNext();
+
+    QNetworkAccessManager*         _nam;
+    ThumbnailStore*                _store;
+    QString                        _httpUrl;
+    QList<Fetch>                   _queue;    // visible covers first
+    QHash<QString, QNetworkReply*> _running;  // key: cover id and size
+};
@@ -0,0 +1,62 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "thumbnailprovider.h"
+
+#include <QReadLocker>
+#include <QWriteLocker>
+
+QImage ThumbnailSource::image(const QString& coverId, int size) const {
+    QReadLocker locker(&_lock);
+    return _store != nullptr ? _store->image(coverId, size) : QImage();
+}
+
+void ThumbnailSource::attach(ThumbnailStore* store) {
+    QWriteLocker locker(&_lock);
+    _store = store;
+}
+
+void ThumbnailSource::release(ThumbnailStore* store) {
+    QWriteLocker locker(&_lock);
+    if (_store == store) {
+        _store = nullptr;
+    }
+}
+
+ThumbnailProvider::ThumbnailProvider(const QSharedPointer<ThumbnailSource>& source)
+    : QQuickImageProvider(QQuickImageProvider::Image), _source(source) {}
+
+QImage ThumbnailProvider::requestImage(const QString& id, QSize* size, const QSize& requestedSize) {
+    int separator = id.lastIndexOf('/');
+    if (separator < 0) {
+        return QImage();
+    }
+
+    QImage image = _source->image(id.left(separator), id.mid(separator + 1).toInt());
+    if (!image.isNull() && requestedSize.isValid() && requestedSize != image.size()) {
+        image = image.scaled(requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    if (size != nullptr) {
+        *size = image.size();
+    }
+    return image;
+}
@@ -0,0 +1,61 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QImage>
+#include <QQuickImageProvider>
+#include <QReadWriteLock>
+#include <QSharedPointer>
+#include <QSize>
+#include <QString>
+
+#include "thumbnailstore.h"
+
+// The store as seen by the image loading threads of QML. The integration releases it before the store is destroyed,
+// release() waits for the requests which are using it.
+class ThumbnailSource {
+ public:
+    explicit ThumbnailSource(ThumbnailStore* store) : _store(store) {}
+
+    QImage image(const QString& coverId, int size) const;
+    void   attach(ThumbnailStore* store);
+    void   release(ThumbnailStore* store);  // only if it is still the attached one
+
+ private:
+    mutable QReadWriteLock _lock;
+    ThumbnailStore*        _store;
+};
+
+// Serves the thumbnails of the store to Image elements straight from the mapped file, image ids are
+// "<cover id>/<size>". Owned by the QML engine, so it may outlive the store and the integration.
+class ThumbnailProvider : public QQuickImageProvider {
+ public:
+    explicit ThumbnailProvider(const QSharedPointer<ThumbnailSource>& source);
+
+    QImage requestImage(const QString& id, QSize* size, const QSize& requestedSize) override;
+
+    QSharedPointer<ThumbnailSource> source() const { return _source; }
+
+ private:
+    const QSharedPointer<ThumbnailSource> _source;
+};
@@ -0,0 +1,310 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "thumbnailstore.h"
+
+#include <QDir>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <algorithm>
+
+static const quint32 RECORD_MAGIC = 0x53515442;  // "SQTB"
+
+ThumbnailStore::ThumbnailStore(const QString& directory, qint64 capacity, QObject* parent)
+    : QObject(parent),
+      _path(directory + "/thumbnails.dat"),
+      _capacity(capacity),
+      _file(_path),
+      _map(nullptr),
+      _mapped(0),
+      _fileBytes(0),
+      _liveBytes(0),
+      _inserted(0),
+      _compactionStart(0) {
+    QDir().mkpath(directory);
+    QObject::connect(&_compaction, &QFutureWatcher<Compaction>::finished, this, &ThumbnailStore::finishCompaction);
+    load();
+}
+
+ThumbnailStore::~ThumbnailStore() {
+    _compaction.waitForFinished();
+    if (_map != nullptr) {
+        _file.unmap(const_cast<uchar*>(_map));
+    }
+}
+
+bool ThumbnailStore::contains(const QString& coverId, int size) const {
+    QReadLocker locker(&_lock);
+    return _index.contains(key(coverId, size));
+}
+
+QByteArray ThumbnailStore::data(const QString& coverId, int size) const {
+    auto entry = _index.constFind(key(coverId, size));
+    if (entry == _index.constEnd() || entry->offset + entry->recordBytes() > _mapped) {
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(reinterpret_cast<const char*>(_map + entry->offset + HEADER_BYTES + entry->keyBytes),
+                                   entry->size);
+}
+
+QImage ThumbnailStore::image(const QString& coverId, int size) const {
+    // decoded while the mapping can't move
+    QReadLocker locker(&_lock);
+    QByteArray  encoded = data(coverId, size);
+    if (encoded.isEmpty()) {
+        return QImage();
+    }
+    return QImage::fromData(encoded);
+}
+
+bool ThumbnailStore::insert(const QString& coverId, int size, const QByteArray& data) {
+    if (!_file.isOpen() || data.isEmpty()) {
+        return false;
+    }
+
+    QWriteLocker locker(&_lock);
+    QString      name = key(coverId, size);
+    QByteArray   bytes = record(name, data);
+    if (!grow(_fileBytes + bytes.size()) || !_file.seek(_fileBytes) || _file.write(bytes) != bytes.size() ||
+        !_file.flush()) {
+        return false;
+    }
+
+    // a replaced thumbnail becomes a hole in the file
+    auto replaced = _index.constFind(name);
+    if (replaced != _index.constEnd()) {
+        _liveBytes -= replaced->recordBytes();
+    }
+
+    Entry entry;
+    entry.offset = _fileBytes;
+    entry.keyBytes = bytes.size() - HEADER_BYTES - data.size();
+    entry.size = data.size();
+    entry.inserted = _inserted++;
+    _index.insert(name, entry);
+    _fileBytes += bytes.size();
+    _liveBytes += bytes.size();
+
+    evict();
+
+    if (!_compaction.isRunning() && _fileBytes - _liveBytes > qMax<qint64>(_liveBytes / 2, 1024 * 1024)) {
+        startCompaction();
+    }
+    return _index.contains(name);
+}
+
+QByteArray ThumbnailStore::record(const QString& key, const QByteArray& data) {
+    QByteArray name = key.toUtf8();
+    QByteArray bytes(HEADER_BYTES, 0);
+    qToLittleEndian<quint32>(RECORD_MAGIC, bytes.data());
+    qToLittleEndian<quint32>(static_cast<quint32>(name.size()), bytes.data() + 4);
+    qToLittleEndian<quint32>(static_cast<quint32>(data.size()), bytes.data() + 8);
+    return bytes + name + data;
+}
+
+void ThumbnailStore::load() {
+    if (!_file.open(QIODevice::ReadWrite)) {
+        return;
+    }
+    map();
+
+    // the index is rebuilt from the record headers, a later record of the same key replaces the earlier one
+    qint64 offset = 0;
+    while (offset + HEADER_BYTES <= _mapped) {
+        const uchar* header = _map + offset;
+        quint32      keyBytes = qFromLittleEndian<quint32>(header + 4);
+        quint32      size = qFromLittleEndian<quint32>(header + 8);
+        if (qFromLittleEndian<quint32>(header) != RECORD_MAGIC ||
+            offset + HEADER_BYTES + keyBytes + size > _mapped) {
+            break;
+        }
+
+        Entry entry;
+        entry.offset = offset;
+        entry.keyBytes = static_cast<qint32>(keyBytes);
+        entry.size = static_cast<qint32>(size);
+        entry.inserted = _inserted++;
+
+        QString name = QString::fromUtf8(reinterpret_cast<const char*>(header + HEADER_BYTES), entry.keyBytes);
+        auto    replaced = _index.constFind(name);
+        if (replaced != _index.constEnd()) {
+            _liveBytes -= replaced->recordBytes();
+        }
+        _index.insert(name, entry);
+        _liveBytes += entry.recordBytes();
+        offset += entry.recordBytes();
+    }
+
+    // the rest is the unused part of the last chunk or a record cut off by a crash, the next insert overwrites it
+    _fileBytes = offset;
+    evict();
+}
+
+void ThumbnailStore::map() {
+    if (_map != nullptr) {
+        _file.unmap(const_cast<uchar*>(_map));
+        _map = nullptr;
+        _mapped = 0;
+    }
+    qint64 bytes = _file.size();
+    if (bytes > 0) {
+        _map = _file.map(0, bytes);
+        _mapped = _map != nullptr ? bytes : 0;
+    }
+}
+
+bool ThumbnailStore::grow(qint64 bytes) {
+    if (bytes <= _mapped) {
+        return true;
+    }
+    if (!_file.resize((bytes + MAP_CHUNK - 1) / MAP_CHUNK * MAP_CHUNK)) {
+        return false;
+    }
+    map();
+    return _mapped >= bytes;
+}
+
+void ThumbnailStore::evict() {
+    if (_liveBytes <= _capacity) {
+        return;
+    }
+
+    // oldest first, down to 90% so not every insert evicts
+    QVector<QPair<qint64, QString>> order;
+    order.reserve(_index.size());
+    for (auto i = _index.constBegin(); i != _index.constEnd(); ++i) {
+        order.append(qMakePair(i->inserted, i.key()));
+    }
+    std::sort(order.begin(), order.end());
+
+    for (const auto& oldest : order) {
+        if (_liveBytes <= _capacity * 9 / 10) {
+            break;
+        }
+        _liveBytes -= _index.take(oldest.second).recordBytes();
+    }
+}
+
+void ThumbnailStore::startCompaction() {
+    _compactionStart = _fileBytes;
+    _compaction.setFuture(QtConcurrent::run(&ThumbnailStore::compactFile, _path, _path + ".compact", _index));
+}
+
+ThumbnailStore::Compaction ThumbnailStore::compactFile(const QString& source, const QString& target,
+                                                       QHash<QString, Entry> index) {
+    Compaction result;
+    QFile      in(source);
+    QFile      out(target);
+    if (!in.open(QIODevice::ReadOnly) || !out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return result;
+    }
+
+    // copied in file order, so the source is read sequentially
+    QVector<QPair<qint64, QString>> order;
+    order.reserve(index.size());
+    for (auto i = index.constBegin(); i != index.constEnd(); ++i) {
+        order.append(qMakePair(i->offset, i.key()));
+    }
+    std::sort(order.begin(), order.end());
+
+    for (const auto& record : order) {
+        Entry&     entry = index[record.second];
+        QByteArray bytes;
+        if (!in.seek(entry.offset) || (bytes = in.read(entry.recordBytes())).size() != entry.recordBytes() ||
+            out.write(bytes) != bytes.size()) {
+            return result;
+        }
+        entry.offset = result.fileBytes;
+        result.fileBytes += bytes.size();
+    }
+    if (!out.flush()) {
+        return result;
+    }
+
+    result.index = index;
+    result.ok = true;
+    return result;
+}
+
+void ThumbnailStore::finishCompaction() {
+    QWriteLocker locker(&_lock);
+    Compaction   result = _compaction.result();
+    QString      target = _path + ".compact";
+    if (!result.ok) {
+        QFile::remove(target);
+        return;
+    }
+
+    // thumbnails inserted meanwhile are appended to the compacted file, evicted and replaced ones are dropped
+    QFile out(target);
+    if (!out.open(QIODevice::Append)) {
+        QFile::remove(target);
+        return;
+    }
+    QHash<QString, Entry> index;
+    qint64                fileBytes = result.fileBytes;
+    for (auto i = _index.constBegin(); i != _index.constEnd(); ++i) {
+        Entry entry = i.value();
+        if (entry.offset < _compactionStart) {
+            entry.offset = result.index.value(i.key()).offset;
+        } else {
+            QByteArray bytes(reinterpret_cast<const char*>(_map + entry.offset), entry.recordBytes());
+            if (out.write(bytes) != bytes.size()) {
+                out.close();
+                QFile::remove(target);
+                return;
+            }
+            entry.offset = fileBytes;
+            fileBytes += bytes.size();
+        }
+        index.insert(i.key(), entry);
+    }
+    out.close();
+
+    // swap the files, the data returned so far points into the old mapping
+    if (_map != nullptr) {
+        _file.unmap(const_cast<uchar*>(_map));
+        _map = nullptr;
+        _mapped = 0;
+    }
+    _file.close();
+    if (!QFile::remove(_path) || !QFile::rename(target, _path)) {
+        QFile::remove(target);
+        _index.clear();
+        _liveBytes = 0;
+        _fileBytes = 0;
+        _inserted = 0;
+        load();
+        return;
+    }
+
+    // thumbnails evicted while the compaction ran were copied and are holes again
+    _index = index;
+    _fileBytes = fileBytes;
+    _liveBytes = 0;
+    for (const Entry& entry : _index) {
+        _liveBytes += entry.recordBytes();
+    }
+    if (_file.open(QIODevice::ReadWrite)) {
+        map();
+    }
+}
@@ -0,0 +1,102 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+
+// Thumbnails of the album grids packed into one append-only file instead of thousands of small files.
+// The file is memory-mapped, so reading a thumbnail is a hash lookup without a system call. The file and the mapping
+// grow in chunks, not with every thumbnail. Replaced and evicted thumbnails leave holes which are removed by a
+// compaction in the background. image() may be called from the image loading threads of QML.
+class ThumbnailStore : public QObject {
+    Q_OBJECT
+
+ public:
+    ThumbnailStore(const QString& directory, qint64 capacity, QObject* parent = nullptr);
+    ~ThumbnailStore() override;
+
+    bool contains(const QString& coverId, int size) const;
+
+    // Points into the mapped file: valid until the next insert() or compaction, copy it to keep it. Only for the
+    // thread of the store, use image() elsewhere.
+    QByteArray data(const QString& coverId, int size) const;
+    QImage     image(const QString& coverId, int size) const;
+
+    // False if the thumbnail could not be written or was evicted right away, it is not in the store then.
+    bool insert(const QString& coverId, int size, const QByteArray& data);
+
+    int    count() const { return _index.size(); }
+    qint64 liveBytes() const { return _liveBytes; }
+    qint64 fileBytes() const { return _fileBytes; }
+
+ private:
+    struct Entry {
+        qint64 offset = 0;    // of the record
+        qint32 keyBytes = 0;  // the image data follows the header and the key
+        qint32 size = 0;      // of the image data
+        qint64 inserted = 0;
+        qint64 recordBytes() const { return HEADER_BYTES + keyBytes + size; }
+    };
+    struct Compaction {
+        QHash<QString, Entry> index;
+        qint64                fileBytes = 0;
+        bool                  ok = false;
+    };
+
+    static const int    HEADER_BYTES = 12;  // magic, key and data length
+    static const qint64 MAP_CHUNK = 4 * 1024 * 1024;
+
+    static QString    key(const QString& coverId, int size) { return coverId + "@" + QString::number(size); }
+    static QByteArray record(const QString& key, const QByteArray& data);
+    static Compaction compactFile(const QString& source, const QString& target, QHash<QString, Entry> index);
+
+    void load();
+    void map();
+    bool grow(qint64 bytes);
+    void evict();
+    void startCompaction();
+    void finishCompaction();
+
+    QString               _path;
+    qint64                _capacity;  // bytes of live thumbnails
+    QFile                 _file;
+    const uchar*          _map;
+    qint64                _mapped;     // the whole file, records and the unused rest of the last chunk
+    qint64                _fileBytes;  // end of the last record
+    qint64                _liveBytes;
+    qint64                _inserted;  // insert counter, oldest thumbnails are evicted first
+    QHash<QString, Entry> _index;     // key: cover id and size
+
+    mutable QReadWriteLock _lock;  // the mapping and the index, written only by the thread of the store
+
+    QFutureWatcher<Compaction> _compaction;
+    qint64                     _compactionStart;  // file size when the compaction started
+};
@@ -0,0 +1,13 @@
+# Throughput of CometdScanner in MB/s, the vector path of the build target against the scalar loop.
+TEMPLATE = app
+TARGET   = cometdbench
+CONFIG  += console c++14
+CONFIG  -= app_bundle
+QT       = core
+
+PLUGIN_SRC = $$clean_path($$PWD/../../src)
+INCLUDEPATH += $$PLUGIN_SRC
+
+HEADERS += $$PLUGIN_SRC/cometdscanner.h
+SOURCES += $$PLUGIN_SRC/cometdscanner.cpp \
+           main.cpp
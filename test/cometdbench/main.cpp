@@ -0,0 +1,177 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <functional>
+
+#include "cometdscanner.h"
+
+// cometdbench [seconds per case]
+// Runs scan() and scanScalar() on typical batches of the streaming connection and prints MB/s of both. The exit
+// code is 1 when the two disagree on any batch.
+
+namespace {
+
+typedef std::function<QVector<CometdMessage>(const QByteArray&)> Scan;
+
+struct Case {
+    QString    name;
+    QByteArray batch;
+};
+
+QJsonObject status(int player, int track, const QString& title) {
+    QJsonObject item;
+    item.insert("playlist index", track);
+    item.insert("id", 100000 + track);
+    item.insert("title", title);
+    item.insert("artist", QString("Artist %1").arg(track % 97));
+    item.insert("album", QString("Album %1").arg(track % 389));
+    item.insert("coverid", QString::number(100000 + track, 16));
+    item.insert("coverart", "1");
+    item.insert("duration", 241.5);
+
+    QJsonObject data;
+    data.insert("player_name", QString("Player %1").arg(player));
+    data.insert("player_connected", 1);
+    data.insert("power", 1);
+    data.insert("mode", "play");
+    data.insert("time", 73.25);
+    data.insert("rate", 1);
+    data.insert("duration", 241.5);
+    data.insert("mixer volume", 45);
+    data.insert("playlist_cur_index", QString::number(track));
+    data.insert("playlist_timestamp", 1600000000.123 + player);
+    data.insert("playlist_tracks", 20);
+    data.insert("playlist_loop", QJsonArray({item}));
+
+    QJsonObject message;
+    message.insert("channel", QString("/slim/5a000001/status/00042000%1").arg(player, 4, 16, QChar('0')));
+    message.insert("id", 1000 + player);
+    message.insert("data", data);
+    return message;
+}
+
+QByteArray batch(const QJsonArray& messages) { return QJsonDocument(messages).toJson(QJsonDocument::Compact); }
+
+QVector<Case> cases() {
+    QVector<Case> result;
+
+    QJsonObject handshake;
+    handshake.insert("channel", "/meta/handshake");
+    handshake.insert("clientId", "5a000001");
+    handshake.insert("successful", true);
+    handshake.insert("version", "1.0");
+    handshake.insert("supportedConnectionTypes", QJsonArray({"long-polling", "streaming"}));
+    result.append({"handshake reply", batch(QJsonArray({handshake}))});
+
+    result.append({"1 status", batch(QJsonArray({status(1, 3, "Track 3")}))});
+
+    QJsonArray burst;
+    for (int i = 0; i < 50; ++i) {
+        burst.append(status(i % 10, i, QString("Track %1").arg(i)));
+    }
+    result.append({"50 statuses", batch(burst)});
+
+    // titles full of quotes, backslashes and non-ASCII text: many structural bytes inside strings
+    QJsonArray escaped;
+    for (int i = 0; i < 50; ++i) {
+        escaped.append(status(i % 10, i, QString("\"Live\" \\ Ünplugged [%1] {Remix}, Part: %1").arg(i)));
+    }
+    result.append({"50 escaped statuses", batch(escaped)});
+    return result;
+}
+
+bool same(const QVector<CometdMessage>& a, const QVector<CometdMessage>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (int i = 0; i < a.size(); ++i) {
+        if (a[i].begin != b[i].begin || a[i].end != b[i].end || a[i].channel != b[i].channel || a[i].id != b[i].id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// MB/s of scan on batch, run for at least msecs
+double throughput(const Scan& scan, const QByteArray& batch, int msecs, int* messages) {
+    QElapsedTimer timer;
+    qint64        bytes = 0;
+    int           count = 0;
+    timer.start();
+    do {
+        for (int i = 0; i < 100; ++i) {
+            count += scan(batch).size();
+            bytes += batch.size();
+        }
+    } while (timer.elapsed() < msecs);
+    *messages = count;  // keeps the calls from being optimized away
+    return bytes / (timer.nsecsElapsed() / 1e9) / (1024 * 1024);
+}
+
+const char* vectorPath() {
+#if defined(__SSE2__)
+    return "SSE2";
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    int              msecs = static_cast<int>(app.arguments().value(1, "1").toDouble() * 1000);
+    QTextStream      out(stdout);
+    bool             mismatch = false;
+    int              messages = 0;
+
+    out << "scan() uses " << vectorPath() << "\n";
+    out << QString("%1 %2 %3 %4 %5\n").arg("case", -22).arg("bytes", 8).arg("scan", 10).arg("scalar", 10).arg("x", 6);
+    for (const Case& test : cases()) {
+        if (!same(CometdScanner::scan(test.batch), CometdScanner::scanScalar(test.batch))) {
+            out << test.name << ": scan() and scanScalar() disagree\n";
+            mismatch = true;
+            continue;
+        }
+
+        double vector = throughput(CometdScanner::scan, test.batch, msecs, &messages);
+        double scalar = throughput(CometdScanner::scanScalar, test.batch, msecs, &messages);
+        out << QString("%1 %2 %3 %4 %5\n")
+                   .arg(test.name, -22)
+                   .arg(test.batch.size(), 8)
+                   .arg(vector, 10, 'f', 1)
+                   .arg(scalar, 10, 'f', 1)
+                   .arg(vector / scalar, 6, 'f', 2);
+    }
+    out << "MB/s\n";
+    return mismatch ? 1 : 0;
+}
@@ -0,0 +1,6 @@
+FUZZ_TARGET = cometdscanner
+include(../fuzz.pri)
+
+HEADERS += $$PLUGIN_SRC/cometdscanner.h
+SOURCES += $$PLUGIN_SRC/cometdscanner.cpp \
+           fuzz_cometdscanner.cpp
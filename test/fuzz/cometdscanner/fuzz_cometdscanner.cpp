@@ -0,0 +1,59 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QByteArray>
+#include <QVector>
+#include <QtGlobal>
+
+#include "cometdscanner.h"
+
+// socketReceived() cuts the messages out of the batch with the boundaries found by the scanner, so they have to be
+// in order, inside of the batch and on braces for any input. The vector path has to find exactly what the scalar
+// loop finds.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    // no copy: the sanitizer catches reads behind the input, the vector loads must not make any
+    QByteArray batch = QByteArray::fromRawData(reinterpret_cast<const char*>(data), static_cast<int>(size));
+
+    QVector<CometdMessage> messages = CometdScanner::scan(batch);
+    QVector<CometdMessage> scalar = CometdScanner::scanScalar(batch);
+    if (messages.size() != scalar.size()) {
+        qFatal("scan() found %d messages, scanScalar() %d", messages.size(), scalar.size());
+    }
+
+    int previousEnd = 0;
+    for (int i = 0; i < messages.size(); ++i) {
+        const CometdMessage& message = messages.at(i);
+        const CometdMessage& expected = scalar.at(i);
+        if (message.begin != expected.begin || message.end != expected.end || message.channel != expected.channel ||
+            message.id != expected.id) {
+            qFatal("message %d differs between scan() and scanScalar()", i);
+        }
+        if (message.begin < previousEnd || message.end <= message.begin || message.end > batch.size()) {
+            qFatal("message %d at %d..%d is out of order or out of the batch", i, message.begin, message.end);
+        }
+        if (batch.at(message.begin) != '{' || batch.at(message.end - 1) != '}') {
+            qFatal("message %d at %d..%d is not cut at braces", i, message.begin, message.end);
+        }
+        previousEnd = message.end;
+    }
+    return 0;
+}
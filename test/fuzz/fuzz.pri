@@ -0,0 +1,17 @@
+# Shared setup of the fuzz targets, FUZZ_TARGET names the target and its corpus directory.
+TEMPLATE = app
+TARGET   = $${FUZZ_TARGET}_fuzzer
+CONFIG  += console c++14
+CONFIG  -= app_bundle
+QT       = core
+
+PLUGIN_SRC = $$clean_path($$PWD/../../src)
+INCLUDEPATH += $$PLUGIN_SRC
+DEFINES += FUZZ_CORPUS=\\\"$$PWD/corpus/$$FUZZ_TARGET\\\"
+
+libfuzzer {
+    QMAKE_CXXFLAGS += -fsanitize=fuzzer,address -g
+    QMAKE_LFLAGS   += -fsanitize=fuzzer,address
+} else {
+    SOURCES += $$PWD/replay.cpp
+}
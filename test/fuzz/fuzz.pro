@@ -0,0 +1,11 @@
+# Fuzz targets of the stages which see the raw server traffic. "qmake CONFIG+=libfuzzer" builds them for libFuzzer
+# (clang only), otherwise each gets a main() which replays its corpus and reports the throughput per input.
+TEMPLATE = subdirs
+SUBDIRS  = cometdscanner \
+           jsonstreamreader \
+           statusdecoder
+
+# The seed corpus in corpus/ is written from the message formats of the Logitech Media Server. It grows with
+# recordings of the mock server of the harness: "sqharness connect --mock N --record <directory>" writes every socket
+# read, CometD batch and RPC reply into the statusdecoder, cometdscanner and jsonstreamreader subdirectories, ready
+# to copy into corpus/.
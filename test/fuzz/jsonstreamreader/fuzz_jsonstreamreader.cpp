@@ -0,0 +1,87 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QByteArray>
+#include <QJsonParseError>
+#include <QStringList>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QtGlobal>
+
+#include "jsonstreamreader.h"
+
+// The reader gets the reply in network chunks of any size. Fed in one piece, byte by byte or in chunks cut by the
+// input itself, it has to hand out the same items and leave the same remainder.
+
+namespace {
+
+struct Result {
+    QStringList  loops;
+    QVariantList items;
+    QVariantMap  rest;
+    int          error = 0;
+    int          itemCount = 0;
+
+    bool operator==(const Result& other) const {
+        return loops == other.loops && items == other.items && rest == other.rest && error == other.error &&
+               itemCount == other.itemCount;
+    }
+};
+
+// chunkSize 0: the chunk sizes are taken from the input
+Result read(const QByteArray& input, int chunkSize) {
+    Result           result;
+    JsonStreamReader reader([&](const QString& loop, const QVariantMap& item) {
+        result.loops.append(loop);
+        result.items.append(item);
+    });
+
+    for (int pos = 0; pos < input.size();) {
+        int size = chunkSize > 0 ? chunkSize : 1 + static_cast<uchar>(input.at(pos)) % 61;
+        reader.feed(input.mid(pos, size));
+        pos += size;
+    }
+
+    QJsonParseError error;
+    result.rest = reader.finish(&error);
+    result.error = error.error;
+    result.itemCount = reader.itemCount();
+    if (result.itemCount != result.items.size()) {
+        qFatal("itemCount() is %d, %d items were handed out", result.itemCount, result.items.size());
+    }
+    return result;
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    QByteArray input = QByteArray::fromRawData(reinterpret_cast<const char*>(data), static_cast<int>(size));
+
+    Result whole = read(input, input.size());
+    if (!(read(input, 1) == whole)) {
+        qFatal("byte by byte differs from one piece");
+    }
+    if (!(read(input, 0) == whole)) {
+        qFatal("chunks cut by the input differ from one piece");
+    }
+    return 0;
+}
@@ -0,0 +1,6 @@
+FUZZ_TARGET = jsonstreamreader
+include(../fuzz.pri)
+
+HEADERS += $$PLUGIN_SRC/jsonstreamreader.h
+SOURCES += $$PLUGIN_SRC/jsonstreamreader.cpp \
+           fuzz_jsonstreamreader.cpp
@@ -0,0 +1,124 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+
+// Replay driver of a fuzz target for builds without libFuzzer.
+// <target>_fuzzer [files or directories]: runs every input, the corpus of the target without arguments. Each input
+// is repeated for at least 10 ms and reported with its time per run and throughput, slowest first, so a decoder
+// regression shows up next to the crashes.
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace {
+
+struct Run {
+    QString file;
+    int     bytes = 0;
+    double  usecs = 0;  // per run
+};
+
+QStringList inputs(const QStringList& paths) {
+    QStringList files;
+    for (const QString& path : paths) {
+        QFileInfo info(path);
+        if (!info.isDir()) {
+            files.append(path);
+            continue;
+        }
+        for (const QFileInfo& file : QDir(path).entryInfoList(QDir::Files, QDir::Name)) {
+            files.append(file.filePath());
+        }
+    }
+    return files;
+}
+
+double megabytesPerSecond(const Run& run) { return run.usecs > 0 ? run.bytes / run.usecs / 1.048576 : 0; }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    QStringList paths;
+    for (int i = 1; i < argc; ++i) {
+        paths.append(QString::fromLocal8Bit(argv[i]));
+    }
+    if (paths.isEmpty()) {
+        paths.append(FUZZ_CORPUS);
+    }
+
+    QTextStream  out(stdout);
+    QVector<Run> runs;
+    qint64       totalBytes = 0;
+    qint64       totalNsecs = 0;
+    for (const QString& path : inputs(paths)) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            out << "can't read " << path << "\n";
+            return 2;
+        }
+        QByteArray     data = file.readAll();
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data.constData());
+
+        // the first run alone, a crash names the input
+        out << path << "\n";
+        out.flush();
+        LLVMFuzzerTestOneInput(bytes, data.size());
+
+        QElapsedTimer timer;
+        int           count = 0;
+        timer.start();
+        do {
+            LLVMFuzzerTestOneInput(bytes, data.size());
+            count++;
+        } while (timer.elapsed() < 10);
+
+        Run run;
+        run.file = QFileInfo(path).fileName();
+        run.bytes = data.size();
+        run.usecs = timer.nsecsElapsed() / 1000.0 / count;
+        runs.append(run);
+        totalBytes += static_cast<qint64>(data.size()) * count;
+        totalNsecs += timer.nsecsElapsed();
+    }
+
+    std::sort(runs.begin(), runs.end(),
+              [](const Run& a, const Run& b) { return megabytesPerSecond(a) < megabytesPerSecond(b); });
+    out << QString("\n%1 %2 %3  %4\n").arg("bytes", 8).arg("us/run", 10).arg("MB/s", 8).arg("input");
+    for (const Run& run : runs) {
+        out << QString("%1 %2 %3  %4\n")
+                   .arg(run.bytes, 8)
+                   .arg(run.usecs, 10, 'f', 2)
+                   .arg(megabytesPerSecond(run), 8, 'f', 1)
+                   .arg(run.file);
+    }
+    out << QString("%1 inputs, %2 MB/s overall\n")
+               .arg(runs.size())
+               .arg(totalNsecs > 0 ? totalBytes * 1000.0 / totalNsecs / 1.048576 : 0, 0, 'f', 1);
+    return 0;
+}
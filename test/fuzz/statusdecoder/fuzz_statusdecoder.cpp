@@ -0,0 +1,70 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QByteArray>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QtGlobal>
+
+#include "cometdscanner.h"
+#include "statusdecoder.h"
+
+// One read of the CometD socket through the stages of socketReceived() and parsePlayerStatus(): the framing has to
+// hand out a line of the read, the batch at most one message or error per scanned message, and the decoded current
+// track has to be an item of the playlist window.
+
+namespace {
+
+const char STATUS_PREFIX[] = "/slim/5a3c1e07/status/";
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    QByteArray read = QByteArray::fromRawData(reinterpret_cast<const char*>(data), static_cast<int>(size));
+
+    QByteArray document = cometdDocument(read);
+    if (document.contains('\r') || document.contains('\n') || !read.contains(document)) {
+        qFatal("the document is not a line of the read");
+    }
+
+    CometdBatch batch = decodeCometdBatch(document, STATUS_PREFIX);
+    int         scanned = CometdScanner::scan(document).size();
+    if (batch.messages.size() + batch.errors.size() > scanned) {
+        qFatal("%d messages and %d errors from %d scanned messages", batch.messages.size(), batch.errors.size(),
+               scanned);
+    }
+    if (batch.lostStatus.size() > batch.errors.size()) {
+        qFatal("%d lost status messages from %d errors", batch.lostStatus.size(), batch.errors.size());
+    }
+
+    for (const QVariant& message : batch.messages) {
+        QVariantMap map = message.toMap();
+        if (!map.value("channel").toString().startsWith(STATUS_PREFIX)) {
+            continue;
+        }
+        PlayerStatus status = decodePlayerStatus(map.value("data").toMap());
+        if (!status.playlistItem.isEmpty() && !status.playlist.contains(status.playlistItem)) {
+            qFatal("the current track is not an item of the playlist window");
+        }
+    }
+    return 0;
+}
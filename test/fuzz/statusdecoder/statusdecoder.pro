@@ -0,0 +1,8 @@
+FUZZ_TARGET = statusdecoder
+include(../fuzz.pri)
+
+HEADERS += $$PLUGIN_SRC/cometdscanner.h \
+           $$PLUGIN_SRC/statusdecoder.h
+SOURCES += $$PLUGIN_SRC/cometdscanner.cpp \
+           $$PLUGIN_SRC/statusdecoder.cpp \
+           fuzz_statusdecoder.cpp
@@ -0,0 +1,594 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "driver.h"
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QLoggingCategory>
+#include <QMetaObject>
+#include <QFile>
+#include <QMap>
+#include <QNetworkReply>
+#include <QTimer>
+#include <QtDebug>
+#include <cmath>
+
+#if defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+#include "latencystats.h"
+#include "squeezebox.h"
+#include "yio-interface/entities/mediaplayerinterface.h"
+
+static Q_LOGGING_CATEGORY(driverLog, "harness.driver");
+
+static const char INTEGRATION_ID[] = "squeezebox.harness";
+
+Driver::Driver(const Options& options, QObject* parent)
+    : QObject(parent),
+      _options(options),
+      _entities(&_clock),
+      _config(QVariantMap()),
+      _plugin(nullptr),
+      _mockProcess(nullptr),
+      _port(options.port),
+      _failed(false) {
+    _clock.start();
+}
+
+Driver::~Driver() {
+    delete _integration;
+    delete _plugin;
+    if (_mockProcess) {
+        _mockProcess->kill();
+        _mockProcess->waitForFinished(5 * 1000);
+    }
+}
+
+QVariantMap Driver::connectRun() {
+    QVariantMap report;
+    report.insert("mode", "connect");
+    if (!setUp() || !connectIntegration(30 * 1000)) {
+        report.insert("failures", _failures);
+        return report;
+    }
+
+    // only the updates of the steady state count, not the initial status of every player
+    _entities.resetCounters();
+    QElapsedTimer observed;
+    observed.start();
+    wait(_options.seconds * 1000);
+
+    QVariantMap entities;
+    entities.insert("count", _entities.entities().size());
+    entities.insert("updates", _entities.totalUpdates());
+    entities.insert("updatesPerSecond", _entities.totalUpdates() * 1000.0 / qMax<qint64>(1, observed.elapsed()));
+    report.insert("entities", entities);
+    report.insert("metrics", metrics());
+    if (_mock) {
+        report.insert("mock", mockMetrics());
+    }
+    report.insert("failures", _failures);
+    return report;
+}
+
+QVariantMap Driver::soakRun() {
+    QVariantMap report;
+    report.insert("mode", "soak");
+    if (_options.mockPlayers <= 0) {
+        fail("the soak run needs the mock server");
+        report.insert("failures", _failures);
+        return report;
+    }
+    if (!setUp() || !connectIntegration(30 * 1000)) {
+        report.insert("failures", _failures);
+        return report;
+    }
+
+    // the timers of the integration run in real time, so the run takes its full duration on the wall clock
+    int          intervalMs = qMax(1, _options.intervalMinutes) * 60 * 1000;
+    int          intervals = qMax(1, static_cast<int>(_options.hours * 60 / qMax(1, _options.intervalMinutes)));
+    int          baselineInterval = qMax(1, intervals / 4);
+    QVariantList samples;
+    QVariantMap  baseline;
+    double       maxDrift = 0;
+    QStringList  players = _mock->players();
+    report.insert("hours", _options.hours);
+    report.insert("intervalMinutes", _options.intervalMinutes);
+    report.insert("mockTimeScale", _options.mockTimeScale);
+
+    for (int interval = 1; interval <= intervals; ++interval) {
+        bool restart = interval % 6 == 0;
+        bool standby = interval % 4 == 2;
+        if (restart) {
+            _mock->dropConnections();
+        }
+
+        // another controller pauses, resumes or skips one of the players
+        QString player = players.at(interval % players.size());
+        if (interval % 3 == 0) {
+            _mock->command(player, {"playlist", "jump", "+1"});
+        } else {
+            _mock->command(player, {"pause", _mock->isPlaying(player) ? "1" : "0"});
+        }
+
+        if (standby) {
+            invoke("enterStandby");
+        }
+        wait(intervalMs / 2);
+        if (standby) {
+            invoke("leaveStandby");
+        }
+        wait(intervalMs / 2);
+
+        if (!waitFor([this]() { return _integration->state() == Integration::CONNECTED; }, 30 * 1000)) {
+            fail(QString("not connected again in interval %1").arg(interval));
+            break;
+        }
+        if (restart) {
+            // the subscriptions push the current status first
+            wait(500);
+        }
+
+        QVariantMap sample = soakSample(interval);
+        samples.append(sample);
+        maxDrift = qMax(maxDrift, sample.value("driftMs").toDouble());
+        if (interval == baselineInterval) {
+            baseline = sample;
+        }
+    }
+    report.insert("samples", samples);
+    report.insert("metrics", metrics());
+    report.insert("mock", mockMetrics());
+
+    if (!samples.isEmpty() && !baseline.isEmpty()) {
+        QVariantMap last = samples.last().toMap();
+        qint64      rssGrowth = last.value("rssKb").toLongLong() - baseline.value("rssKb").toLongLong();
+        int         objectGrowth = last.value("objects").toInt() - baseline.value("objects").toInt();
+        if (last.value("rssKb").toLongLong() >= 0 && rssGrowth > _options.maxRssGrowthKb) {
+            fail(QString("RSS grew by %1 KB after interval %2").arg(rssGrowth).arg(baselineInterval));
+        }
+        if (objectGrowth > _options.maxObjectGrowth) {
+            fail(QString("%1 more live objects than after interval %2").arg(objectGrowth).arg(baselineInterval));
+        }
+        if (last.value("subscriptions").toInt() > players.size()) {
+            fail(QString("%1 subscriptions for %2 players")
+                     .arg(last.value("subscriptions").toInt())
+                     .arg(players.size()));
+        }
+        if (maxDrift > _options.maxDriftMs) {
+            fail(QString("playback position drifted by %1 ms").arg(maxDrift, 0, 'f', 0));
+        }
+
+        QVariantMap growth;
+        growth.insert("fromInterval", baselineInterval);
+        growth.insert("rssKb", rssGrowth);
+        growth.insert("objects", objectGrowth);
+        growth.insert("maxDriftMs", maxDrift);
+        report.insert("growth", growth);
+    }
+    report.insert("failures", _failures);
+    return report;
+}
+
+QVariantMap Driver::latencyRun() {
+    QVariantMap report;
+    report.insert("mode", "latency");
+    report.insert("latencyMs", _options.latency);
+    if (_options.mockPlayers <= 0) {
+        fail("the latency run needs the mock server");
+        report.insert("failures", _failures);
+        return report;
+    }
+    if (!setUp() || !connectIntegration(30 * 1000)) {
+        report.insert("failures", _failures);
+        return report;
+    }
+
+    QStringList players = _mock->players();
+    QStringList commands = {"pause", "play", "volume", "next"};
+    QVariantMap transports;
+    for (const QString& transport : {"http", "cometd"}) {
+        QMap<QString, LatencyStats> shown;
+        QMap<QString, LatencyStats> confirmed;
+        int                         timeouts = 0;
+        for (const QString& name : commands) {
+            shown.insert(name, LatencyStats(_options.iterations));
+            confirmed.insert(name, LatencyStats(_options.iterations));
+        }
+
+        for (int i = 0; i < _options.iterations; ++i) {
+            QString     mac = players.at(i % players.size());
+            FakeEntity* entity = _entities.entity(mac);
+            int         volume = entity->attribute(MediaPlayerDef::VOLUME).toInt() == 30 ? 60 : 30;
+            QString     title = entity->attribute(MediaPlayerDef::MEDIATITLE).toString();
+
+            for (const QString& name : commands) {
+                int                              command = MediaPlayerDef::C_NEXT;
+                QVariant                         param;
+                std::function<bool(FakeEntity*)> result = [=](FakeEntity* e) {
+                    return e->attribute(MediaPlayerDef::MEDIATITLE).toString() != title;
+                };
+                if (name == "pause") {
+                    command = MediaPlayerDef::C_PAUSE;
+                    result = [](FakeEntity* e) { return e->state() == MediaPlayerDef::IDLE; };
+                } else if (name == "play") {
+                    command = MediaPlayerDef::C_PLAY;
+                    result = [](FakeEntity* e) { return e->state() == MediaPlayerDef::PLAYING; };
+                } else if (name == "volume") {
+                    command = MediaPlayerDef::C_VOLUME_SET;
+                    param = volume;
+                    result = [=](FakeEntity* e) { return e->attribute(MediaPlayerDef::VOLUME).toInt() == volume; };
+                }
+
+                qint64 shownUs = 0;
+                qint64 confirmedUs = 0;
+                if (measureCommand(transport, mac, command, param, result, &shownUs, &confirmedUs)) {
+                    shown[name].add(shownUs);
+                    confirmed[name].add(confirmedUs);
+                } else {
+                    timeouts++;
+                }
+            }
+        }
+
+        QVariantMap results;
+        for (const QString& name : commands) {
+            QVariantMap command;
+            command.insert("shownUs", shown[name].toMap());
+            command.insert("confirmedUs", confirmed[name].toMap());
+            results.insert(name, command);
+        }
+        results.insert("timeouts", timeouts);
+        transports.insert(transport, results);
+        if (timeouts > 0) {
+            fail(QString("%1 commands over %2 were not confirmed within 5 s").arg(timeouts).arg(transport));
+        }
+    }
+    report.insert("transports", transports);
+    report.insert("metrics", metrics());
+    report.insert("mock", mockMetrics());
+    report.insert("failures", _failures);
+    return report;
+}
+
+QVariantMap Driver::scaleRun() {
+    QVariantMap report;
+    report.insert("mode", "scale");
+    report.insert("players", _options.mockPlayers);
+
+    // the peak RSS of this run only: 5 resets VmHWM on Linux
+    QFile clearRefs("/proc/self/clear_refs");
+    if (clearRefs.open(QIODevice::WriteOnly)) {
+        clearRefs.write("5");
+        clearRefs.close();
+    }
+
+    _options.mockProcess = true;
+    if (!setUp() || !connectIntegration(60 * 1000)) {
+        report.insert("failures", _failures);
+        return report;
+    }
+    report.insert("handshakeMs", _integration->performance().value("handshakeMs"));
+    report.insert("rssAfterHandshakeKb", memoryKb("VmRSS"));
+
+    // a 1 ms timer which fires late shows how long the UI thread was blocked
+    QElapsedTimer stallClock;
+    QTimer        ticker;
+    qint64        lastTick = 0;
+    qint64        maxStallUs = 0;
+    int           longStalls = 0;
+    ticker.setTimerType(Qt::PreciseTimer);
+    ticker.setInterval(1);
+    QObject::connect(&ticker, &QTimer::timeout, this, [&]() {
+        qint64 now = stallClock.nsecsElapsed() / 1000;
+        qint64 stall = now - lastTick - 1000;
+        maxStallUs = qMax(maxStallUs, stall);
+        if (stall > 16 * 1000) {
+            longStalls++;  // a frame of the UI missed
+        }
+        lastTick = now;
+    });
+
+    // the receive and parse statistics keep the latest 64 samples, read often enough to see every maximum
+    QTimer sampler;
+    qint64 maxReceiveUs = 0;
+    qint64 maxParseUs = 0;
+    sampler.setInterval(250);
+    QObject::connect(&sampler, &QTimer::timeout, this, [&]() {
+        QVariantMap performance = _integration->performance();
+        maxReceiveUs = qMax(maxReceiveUs, performance.value("receiveUs").toMap().value("max").toLongLong());
+        maxParseUs = qMax(maxParseUs, performance.value("parseStatusUs").toMap().value("max").toLongLong());
+    });
+
+    _entities.resetCounters();
+    qint64        cpuStart = cpuMs();
+    QElapsedTimer observed;
+    observed.start();
+    stallClock.start();
+    ticker.start();
+    sampler.start();
+    wait(_options.seconds * 1000);
+    ticker.stop();
+    sampler.stop();
+
+    double seconds = observed.elapsed() / 1000.0;
+    report.insert("cpuMsPerSecond", cpuStart >= 0 ? (cpuMs() - cpuStart) / seconds : -1);
+    report.insert("peakRssKb", memoryKb("VmHWM"));
+    report.insert("maxStallUs", maxStallUs);
+    report.insert("stallsOver16Ms", longStalls);
+    report.insert("maxReceiveUs", maxReceiveUs);
+    report.insert("maxParseStatusUs", maxParseUs);
+    report.insert("entityUpdatesPerSecond", _entities.totalUpdates() / seconds);
+    report.insert("metrics", metrics());
+    report.insert("failures", _failures);
+    return report;
+}
+
+bool Driver::setUp() {
+    _host = _options.host;
+    if (_options.mockPlayers > 0 && _options.mockProcess) {
+        if (!startMockProcess()) {
+            return false;
+        }
+        for (int i = 1; i <= _options.mockPlayers; ++i) {
+            _entities.add(MockLms::mac(i), INTEGRATION_ID, MockLms::mac(i));
+        }
+    } else if (_options.mockPlayers > 0) {
+        _mock = new MockLms(this);
+        _mock->setLatency(_options.latency);
+        _mock->setTimeScale(_options.mockTimeScale);
+        _mock->setPushInterval(_options.pushInterval);
+        _mock->setRecordDirectory(_options.recordDirectory);
+        _mock->addPlayers(_options.mockPlayers);
+        if (!_mock->listen()) {
+            fail("mock server can't listen");
+            return false;
+        }
+        _host = "127.0.0.1";
+        _port = _mock->port();
+
+        // the players are configured already, like in the app after the first discovery
+        for (const QString& mac : _mock->players()) {
+            _entities.add(mac, INTEGRATION_ID, mac);
+        }
+    }
+
+    QVariantMap config;
+    config.insert("id", INTEGRATION_ID);
+    config.insert("friendly_name", "Squeezebox harness");
+    config.insert("url", _host);
+    config.insert("port", static_cast<int>(_port));
+
+    _plugin = new SqueezeboxPlugin();
+    _integration = new Squeezebox(config, &_entities, &_notifications, &_api, &_config, _plugin);
+
+    // players found on a real server are adopted as soon as the integration announces them
+    _entities.setAdoptHook([this](FakeEntity*) {
+        if (_integration) {
+            QMetaObject::invokeMethod(_integration, "refreshEntities", Qt::QueuedConnection);
+        }
+    });
+    return true;
+}
+
+bool Driver::startMockProcess() {
+    QStringList arguments = {"serve", "--mock", QString::number(_options.mockPlayers), "--port", "0", "--latency",
+                             QString::number(_options.latency), "--mock-time-scale",
+                             QString::number(_options.mockTimeScale), "--push-interval",
+                             QString::number(_options.pushInterval)};
+    if (!_options.recordDirectory.isEmpty()) {
+        arguments << "--record" << _options.recordDirectory;
+    }
+    _mockProcess = new QProcess(this);
+    _mockProcess->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    _mockProcess->start(QCoreApplication::applicationFilePath(), arguments);
+    if (!_mockProcess->waitForStarted(5 * 1000)) {
+        fail("mock server process didn't start");
+        return false;
+    }
+
+    // the mock prints "port <number>" once it listens
+    if (!waitFor([this]() { return _mockProcess->canReadLine(); }, 10 * 1000)) {
+        fail("mock server process doesn't listen");
+        return false;
+    }
+    _host = "127.0.0.1";
+    _port = static_cast<quint16>(_mockProcess->readLine().trimmed().mid(5).toUInt());
+    return true;
+}
+
+bool Driver::connectIntegration(int timeoutMs) {
+    QElapsedTimer timer;
+    timer.start();
+    invoke("connect");
+    if (!waitFor([this]() { return _integration->state() == Integration::CONNECTED; }, timeoutMs)) {
+        fail(QString("not connected after %1 ms").arg(timeoutMs));
+        return false;
+    }
+    qCInfo(driverLog) << "Connected to" << _host << _port << "in" << timer.elapsed() << "ms";
+    return true;
+}
+
+bool Driver::waitFor(const std::function<bool()>& condition, int timeoutMs) {
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition()) {
+        if (timer.elapsed() >= timeoutMs) {
+            return false;
+        }
+        wait(10);
+    }
+    return true;
+}
+
+void Driver::wait(int msecs) {
+    QEventLoop loop;
+    QTimer::singleShot(msecs, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+bool Driver::measureCommand(const QString& transport, const QString& mac, int command, const QVariant& param,
+                            const std::function<bool(FakeEntity*)>& shown, qint64* shownUs, qint64* confirmedUs) {
+    FakeEntity* entity = _entities.entity(mac);
+    qint64      shownAt = -1;
+    qint64      executedAt = -1;
+    qint64      confirmedAt = -1;
+
+    // a status counts as confirmation once the mock executed the command, earlier ones can't carry its effect
+    QMetaObject::Connection executed =
+        QObject::connect(_mock, &MockLms::commandReceived, this, [&](const QString& player, const QStringList&) {
+            if (player == mac && executedAt < 0) {
+                executedAt = _clock.nsecsElapsed();
+            }
+        });
+    entity->setUpdateHook([&](FakeEntity* e, int) {
+        if (!shown(e)) {
+            return;
+        }
+        qint64 now = _clock.nsecsElapsed();
+        if (shownAt < 0) {
+            shownAt = now;
+        }
+        if (executedAt >= 0 && confirmedAt < 0) {
+            confirmedAt = now;
+        }
+    });
+
+    qint64 sent = _clock.nsecsElapsed();
+    if (transport == "cometd") {
+        _integration->groupCommand({mac}, command, param);
+    } else {
+        _integration->sendCommand("media_player", mac, command, param);
+    }
+    bool done = waitFor([&]() { return confirmedAt >= 0; }, 5 * 1000);
+
+    entity->setUpdateHook(nullptr);
+    QObject::disconnect(executed);
+    if (!done) {
+        return false;
+    }
+    *shownUs = (shownAt - sent) / 1000;
+    *confirmedUs = (confirmedAt - sent) / 1000;
+
+    // pushes of other players and the rest of the burst settle before the next command
+    wait(50);
+    return true;
+}
+
+void Driver::invoke(const char* slot) {
+    // connect, disconnect and the standby slots are private in the integration, the app reaches them as slots too
+    QMetaObject::invokeMethod(_integration, slot);
+}
+
+QVariantMap Driver::soakSample(int interval) const {
+    QVariantMap sample;
+    sample.insert("interval", interval);
+    sample.insert("minutes", interval * _options.intervalMinutes);
+    sample.insert("rssKb", memoryKb("VmRSS"));
+    sample.insert("objects", _integration->findChildren<QObject*>().size());
+    sample.insert("replies", _integration->findChildren<QNetworkReply*>().size());
+    sample.insert("subscriptions", _integration->performance().value("subscriptions"));
+    sample.insert("driftMs", maxDriftMs());
+    sample.insert("entityUpdates", _entities.totalUpdates());
+    return sample;
+}
+
+double Driver::maxDriftMs() const {
+    double drift = 0;
+    double trackSeconds = _mock->trackSeconds();
+    qint64 now = _integration->now();
+    for (const QString& mac : _mock->players()) {
+        QVariantMap position = _integration->playbackPosition(mac);
+        double      rate = position.value("rate").toDouble();
+        if (!_mock->isPlaying(mac) || rate <= 0) {
+            continue;
+        }
+
+        // a track change which is not pushed yet shows as a difference of almost a whole track
+        double shown = position.value("position").toDouble() +
+                       rate * (now - position.value("timestamp").toLongLong()) / 1000.0;
+        double difference = std::fmod(std::abs(shown - _mock->position(mac)), trackSeconds);
+        difference = qMin(difference, trackSeconds - difference);
+
+        // in real time, a scaled clock of the mock multiplies every delay
+        drift = qMax(drift, difference * 1000 / _options.mockTimeScale);
+    }
+    return drift;
+}
+
+qint64 Driver::memoryKb(const QByteArray& field) {
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    for (const QByteArray& line : status.readAll().split('\n')) {
+        if (line.startsWith(field + ":")) {
+            return line.mid(field.size() + 1).trimmed().split(' ').first().toLongLong();
+        }
+    }
+    return -1;
+}
+
+qint64 Driver::cpuMs() {
+#if defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000LL +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+#else
+    return -1;
+#endif
+}
+
+QVariantMap Driver::metrics() const {
+    QVariantMap result;
+    if (!_integration) {
+        return result;
+    }
+    result.insert("performance", _integration->performance());
+    result.insert("commandLatency", _integration->commandLatency());
+    result.insert("notifications", _notifications.count());
+    result.insert("apiMessages", _api.messages());
+    return result;
+}
+
+QVariantMap Driver::mockMetrics() const {
+    QVariantMap result;
+    result.insert("rpcRequests", _mock->rpcRequests());
+    result.insert("cometdMessages", _mock->cometdMessages());
+    result.insert("pushes", _mock->pushes());
+    result.insert("bytesSent", _mock->bytesSent());
+    result.insert("connections", _mock->connections());
+    result.insert("subscriptions", _mock->subscriptions());
+    return result;
+}
+
+void Driver::fail(const QString& reason) {
+    qCWarning(driverLog) << "Failed:" << reason;
+    _failed = true;
+    _failures.append(reason);
+}
@@ -0,0 +1,123 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include <functional>
+
+#include "fakes.h"
+#include "mocklms.h"
+
+class Squeezebox;
+class SqueezeboxPlugin;
+
+// Runs the integration headless: creates it with the fakes, connects it to the server or to the mock and collects
+// what the run measured. Every run returns a report, the mode decides what goes in.
+class Driver : public QObject {
+    Q_OBJECT
+
+ public:
+    struct Options {
+        QString host;
+        quint16 port = 9000;
+        int     mockPlayers = 0;           // > 0: in-process mock server instead of host and port
+        bool    mockProcess = false;       // the mock runs in a child process, its CPU time doesn't count
+        int     seconds = 10;              // observed after the connection is up
+        int     latency = 0;               // one way msecs of the mock
+        double  mockTimeScale = 1;         // seconds of the mock's clock per real second, not of the integration
+        int     pushInterval = 60 * 1000;  // of the mock, status of the playing players without a change
+        QString recordDirectory;           // the mock writes its traffic there, the corpus of the fuzz targets
+
+        // soak: real duration and the growth which fails the run, measured against the end of the first quarter
+        double hours = 24;
+        int    intervalMinutes = 60;  // of the events and samples
+        int    maxRssGrowthKb = 8192;
+        int    maxObjectGrowth = 50;
+        int    maxDriftMs = 500;  // playback position of the entities against the mock, in real time
+
+        int iterations = 50;  // latency: rounds of pause, play, volume and next per transport
+    };
+
+    explicit Driver(const Options& options, QObject* parent = nullptr);
+    ~Driver();
+
+    // connects, counts the entity updates while observing and reports the metrics of the integration
+    QVariantMap connectRun();
+
+    // hours on the wall clock: playback, commands of other controllers, server restarts every 6 and standby every
+    // 4 intervals. RSS, live objects, subscriptions and position drift are sampled every interval. The time scale
+    // of the mock speeds up its playback only, the timers of the integration always run in real time.
+    QVariantMap soakRun();
+
+    // pause, play, volume and next over HTTP (sendCommand) and CometD (groupCommand) on the mock. Measured until
+    // the entity shows the result first, which may be the optimistic update, and until a status from after the
+    // execution on the server shows it.
+    QVariantMap latencyRun();
+
+    // players of the mock in a child process: handshake duration, CPU time and peak RSS of this process, the longest
+    // stall of the event loop and the longest receive and status parse of the integration while observing
+    QVariantMap scaleRun();
+
+    bool failed() const { return _failed; }
+
+ private:
+    bool setUp();
+    bool startMockProcess();
+    bool connectIntegration(int timeoutMs);
+    bool waitFor(const std::function<bool()>& condition, int timeoutMs);
+    void wait(int msecs);
+    void invoke(const char* slot);
+
+    bool measureCommand(const QString& transport, const QString& mac, int command, const QVariant& param,
+                        const std::function<bool(FakeEntity*)>& shown, qint64* shownUs, qint64* confirmedUs);
+
+    QVariantMap   soakSample(int interval) const;
+    double        maxDriftMs() const;
+    static qint64 memoryKb(const QByteArray& field);  // of /proc/self/status, -1 where there is none
+    static qint64 cpuMs();                            // user and system time of the process, -1 where unknown
+
+    QVariantMap metrics() const;
+    QVariantMap mockMetrics() const;
+    void        fail(const QString& reason);
+
+    Options              _options;
+    QElapsedTimer        _clock;
+    FakeEntities         _entities;
+    FakeNotifications    _notifications;
+    FakeYioApi           _api;
+    FakeConfig           _config;
+    SqueezeboxPlugin*    _plugin;
+    QPointer<Squeezebox> _integration;
+    QPointer<MockLms>    _mock;
+    QProcess*            _mockProcess;
+    QString              _host;
+    quint16              _port;
+    bool                 _failed;
+    QStringList          _failures;
+};
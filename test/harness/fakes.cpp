@@ -0,0 +1,149 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "fakes.h"
+
+#include <QLoggingCategory>
+#include <QtDebug>
+
+static Q_LOGGING_CATEGORY(harnessLog, "harness");
+
+FakeEntity::FakeEntity(const QString& entityId, const QString& type, const QString& integration,
+                       const QString& friendlyName, const QStringList& features, const QElapsedTimer* clock)
+    : _entityId(entityId),
+      _type(type),
+      _integration(integration),
+      _friendlyName(friendlyName),
+      _features(features),
+      _clock(clock),
+      _state(0),
+      _connected(true),
+      _updates(0),
+      _stateChanges(0),
+      _lastUpdate(0) {}
+
+void FakeEntity::resetCounters() {
+    _updates = 0;
+    _stateChanges = 0;
+}
+
+bool FakeEntity::setState(int state) {
+    _state = state;
+    _stateChanges++;
+    touched(STATE);
+    return true;
+}
+
+bool FakeEntity::updateAttrByName(const QString& attrName, const QVariant& value) {
+    _namedAttributes.insert(attrName, value);
+    touched(NAMED);
+    return true;
+}
+
+bool FakeEntity::updateAttrByIndex(int attrIndex, const QVariant& value) {
+    _attributes.insert(attrIndex, value);
+    touched(attrIndex);
+    return true;
+}
+
+void FakeEntity::touched(int attrIndex) {
+    _updates++;
+    _lastUpdate = _clock->nsecsElapsed();
+    if (_hook) {
+        _hook(this, attrIndex);
+    }
+}
+
+FakeEntities::FakeEntities(const QElapsedTimer* clock, bool autoAdopt) : _clock(clock), _autoAdopt(autoAdopt) {}
+
+FakeEntities::~FakeEntities() { qDeleteAll(_entities); }
+
+FakeEntity* FakeEntities::add(const QString& entityId, const QString& integration, const QString& friendlyName) {
+    FakeEntity* entity = _entities.value(entityId);
+    if (entity == nullptr) {
+        entity = new FakeEntity(entityId, "media_player", integration, friendlyName, QStringList(), _clock);
+        _entities.insert(entityId, entity);
+    }
+    return entity;
+}
+
+qint64 FakeEntities::totalUpdates() const {
+    qint64 total = 0;
+    for (FakeEntity* entity : _entities) {
+        total += entity->updates();
+    }
+    return total;
+}
+
+void FakeEntities::resetCounters() {
+    for (FakeEntity* entity : _entities) {
+        entity->resetCounters();
+    }
+}
+
+QList<EntityInterface*> FakeEntities::getByIntegration(const QString& integration) {
+    QList<EntityInterface*> result;
+    for (FakeEntity* entity : _entities) {
+        if (entity->integration() == integration) {
+            result.append(entity);
+        }
+    }
+    return result;
+}
+
+void FakeEntities::removeMediaplayersPlaying(const QString& entityId) { _playing.removeAll(entityId); }
+
+bool FakeEntities::addAvailableEntity(const QString& entityId, const QString& type, const QString& integration,
+                                      const QString& friendlyName, const QStringList& supportedFeatures) {
+    Q_UNUSED(type)
+    Q_UNUSED(supportedFeatures)
+    bool added = !_available.contains(entityId);
+    _available.insert(entityId, integration);
+
+    if (_autoAdopt && !_entities.contains(entityId)) {
+        FakeEntity* entity = add(entityId, integration, friendlyName);
+        if (_adoptHook) {
+            _adoptHook(entity);
+        }
+    }
+    return added;
+}
+
+void FakeNotifications::add(bool type, const QString& text, const QString& actionlabel, void (*f)(QObject*),
+                            QObject* param) {
+    Q_UNUSED(f)
+    Q_UNUSED(param)
+    _count++;
+    qCInfo(harnessLog) << "Notification" << (type ? "(error):" : ":") << text << "action:" << actionlabel;
+}
+
+void FakeNotifications::add(bool type, const QString& text) {
+    _count++;
+    qCInfo(harnessLog) << "Notification" << (type ? "(error):" : ":") << text;
+}
+
+void FakeNotifications::add(const QString& text) { add(false, text); }
+
+void FakeYioApi::sendMessage(QString message) {
+    Q_UNUSED(message)
+    _messages++;
+}
@@ -0,0 +1,189 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVariantMap>
+#include <functional>
+
+#include "yio-interface/configinterface.h"
+#include "yio-interface/entities/entitiesinterface.h"
+#include "yio-interface/entities/entityinterface.h"
+#include "yio-interface/notificationsinterface.h"
+#include "yio-interface/yioapiinterface.h"
+
+// Lightweight stand-ins of the YIO app objects handed to an integration. They keep only what the integration
+// writes and count it, so the driver can run the plugin without the app and the QML UI.
+// They implement the interfaces of the integrations.library version pinned in dependencies.cfg, harness.pro checks it.
+
+// Player entity: counts the attribute updates and state changes and timestamps the last one.
+class FakeEntity : public EntityInterface {
+ public:
+    // attrIndex of the update hook for state changes and for updates by attribute name
+    static const int STATE = -1;
+    static const int NAMED = -2;
+
+    typedef std::function<void(FakeEntity* entity, int attrIndex)> UpdateHook;
+
+    FakeEntity(const QString& entityId, const QString& type, const QString& integration, const QString& friendlyName,
+               const QStringList& features, const QElapsedTimer* clock);
+
+    void setUpdateHook(const UpdateHook& hook) { _hook = hook; }
+
+    int      updates() const { return _updates; }
+    int      stateChanges() const { return _stateChanges; }
+    qint64   lastUpdateNs() const { return _lastUpdate; }  // on the clock of the driver
+    QVariant attribute(int attrIndex) const { return _attributes.value(attrIndex); }
+    void     resetCounters();
+
+    // EntityInterface
+    QString     type() override { return _type; }
+    QString     area() override { return QString(); }
+    QString     friendly_name() override { return _friendlyName; }
+    QString     entity_id() override { return _entityId; }
+    QString     integration() override { return _integration; }
+    QStringList supported_features() override { return _features; }
+    QVariant    custom_features() override { return QVariant(); }
+    bool        favorite() override { return false; }
+    void        setFavorite(bool) override {}
+    int         state() override { return _state; }
+    bool        setState(int state) override;
+    bool        isOn() override { return _state != 0; }
+    bool        isSupported(int) override { return true; }
+    bool        updateAttrByName(const QString& attrName, const QVariant& value) override;
+    bool        updateAttrByIndex(int attrIndex, const QVariant& value) override;
+    void        setConnected(bool value) override { _connected = value; }
+    bool        connected() override { return _connected; }
+    void*       getSpecificInterface() override { return nullptr; }
+
+ private:
+    void touched(int attrIndex);
+
+    QString                  _entityId;
+    QString                  _type;
+    QString                  _integration;
+    QString                  _friendlyName;
+    QStringList              _features;
+    const QElapsedTimer*     _clock;
+    UpdateHook               _hook;
+    int                      _state;
+    bool                     _connected;
+    int                      _updates;
+    int                      _stateChanges;
+    qint64                   _lastUpdate;
+    QHash<int, QVariant>     _attributes;       // key: attribute index
+    QHash<QString, QVariant> _namedAttributes;  // key: attribute name
+};
+
+// Entity registry. Entities announced by the integration are adopted right away when autoAdopt is set, as if the
+// user had added all of them in the app.
+class FakeEntities : public EntitiesInterface {
+ public:
+    explicit FakeEntities(const QElapsedTimer* clock, bool autoAdopt = true);
+    ~FakeEntities();
+
+    FakeEntity*        add(const QString& entityId, const QString& integration, const QString& friendlyName);
+    FakeEntity*        entity(const QString& entityId) const { return _entities.value(entityId); }
+    QList<FakeEntity*> entities() const { return _entities.values(); }
+    int                available() const { return _available.size(); }
+    void               setAdoptHook(const std::function<void(FakeEntity*)>& hook) { _adoptHook = hook; }
+
+    qint64 totalUpdates() const;
+    void   resetCounters();
+
+    // EntitiesInterface
+    QList<EntityInterface*> getByIntegration(const QString& integration) override;
+    EntityInterface*        getEntityInterface(const QString& entityId) override { return _entities.value(entityId); }
+    void                    addMediaplayersPlaying(const QString& entityId) override { _playing.append(entityId); }
+    void                    removeMediaplayersPlaying(const QString& entityId) override;
+    bool                    addAvailableEntity(const QString& entityId, const QString& type,
+                                               const QString& integration, const QString& friendlyName,
+                                               const QStringList& supportedFeatures) override;
+    bool removeAvailableEntity(const QString& entityId) override { return _available.remove(entityId) > 0; }
+
+ private:
+    const QElapsedTimer*             _clock;
+    bool                             _autoAdopt;
+    QHash<QString, FakeEntity*>      _entities;   // key: entity id
+    QHash<QString, QString>          _available;  // key: entity id, value: integration
+    QStringList                      _playing;
+    std::function<void(FakeEntity*)> _adoptHook;
+};
+
+// Notifications are logged instead of shown.
+class FakeNotifications : public NotificationsInterface {
+ public:
+    int count() const { return _count; }
+
+    // NotificationsInterface
+    void add(bool type, const QString& text, const QString& actionlabel, void (*f)(QObject*), QObject* param) override;
+    void add(bool type, const QString& text) override;
+    void add(const QString& text) override;
+    void remove(int id) override { Q_UNUSED(id) }
+    void remove(const QString& text) override { Q_UNUSED(text) }
+
+ private:
+    int _count = 0;
+};
+
+// Configuration of the app, only the integration's own settings are of interest.
+class FakeConfig : public ConfigInterface {
+ public:
+    explicit FakeConfig(const QVariantMap& config) : _config(config) {}
+
+    // ConfigInterface
+    QVariantMap getConfig() override { return _config; }
+    void        setConfig(const QVariantMap& config) override { _config = config; }
+    QVariantMap getSettings() override { return QVariantMap(); }
+    QVariantMap getIntegrations() override { return QVariantMap(); }
+    QVariantMap getAllEntities() override { return QVariantMap(); }
+    QVariantMap getProfiles() override { return QVariantMap(); }
+    QVariantMap getUIConfig() override { return QVariantMap(); }
+    QObject*    getQMLObject(QList<QObject*>, const QString&) override { return nullptr; }
+    QObject*    getQMLObject(const QString&) override { return nullptr; }
+
+ private:
+    QVariantMap _config;
+};
+
+// API of the app towards the web configurator and other remotes, messages are counted.
+class FakeYioApi : public YioAPIInterface {
+ public:
+    int messages() const { return _messages; }
+
+    // YioAPIInterface
+    void        sendMessage(QString message) override;
+    QVariantMap getConfig() override { return QVariantMap(); }
+    bool        setConfig(QVariantMap) override { return true; }
+    bool        addEntityToConfig(QVariantMap) override { return true; }
+    void        discoverNetworkServices() override {}
+    void        discoverNetworkServices(QString) override {}
+
+ private:
+    int _messages = 0;
+};
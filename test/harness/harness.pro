@@ -0,0 +1,78 @@
+# Headless driver: runs the integration against fakes of the YIO app interfaces and a real or mocked server.
+TEMPLATE = app
+TARGET   = sqharness
+CONFIG  += console c++14
+CONFIG  -= app_bundle
+QT      += core quick network concurrent
+
+INTG_LIB_PATH = $$(YIO_SRC)
+isEmpty(INTG_LIB_PATH) {
+    INTG_LIB_PATH = $$clean_path($$PWD/../../../integrations.library)
+    message("Environment variables YIO_SRC not defined! Using '$$INTG_LIB_PATH' for integrations.library project.")
+} else {
+    INTG_LIB_PATH = $$(YIO_SRC)/integrations.library
+    message("YIO_SRC is set: using '$$INTG_LIB_PATH' for integrations.library project.")
+}
+
+! include($$INTG_LIB_PATH/yio-plugin-lib.pri) {
+    error( "Cannot find the yio-plugin-lib.pri file!" )
+}
+
+# the fakes implement the interfaces of the integrations.library version the plugin requires
+unix {
+    INTG_LIB_VERSION = $$system(cat $$PWD/../../dependencies.cfg | awk '/^integrations.library:/$$system_quote("{print $2}")')
+    INTG_GIT_VERSION = "$$system(cd $$INTG_LIB_PATH && git describe --match "v[0-9]*" --tags HEAD --always)"
+    INTG_GIT_BRANCH  = "$$system(cd $$INTG_LIB_PATH && git rev-parse --abbrev-ref HEAD)"
+    !contains(INTG_GIT_VERSION, $$re_escape($${INTG_LIB_VERSION}).*)) {
+        !equals(INTG_GIT_BRANCH, $$INTG_LIB_VERSION) {
+            error("Invalid integrations.library version: \"$$INTG_GIT_VERSION\". Please check out required version \"$$INTG_LIB_VERSION\"")
+        }
+    }
+}
+
+# The plugin sources are compiled in, so the driver can construct the integration directly and reach its
+# performance counters. The built plugin library, its PluginInterface factory and the config handling of the app
+# are not exercised.
+PLUGIN_SRC = $$clean_path($$PWD/../../src)
+DEFINES += PLUGIN_VERSION=\\\"harness\\\"
+
+pluginjson.input  = $$PWD/../../squeezebox.json.in
+pluginjson.output = $$OUT_PWD/squeezebox.json
+QMAKE_SUBSTITUTES += pluginjson
+INCLUDEPATH += $$OUT_PWD $$PLUGIN_SRC
+
+HEADERS += $$PLUGIN_SRC/squeezebox.h \
+           $$PLUGIN_SRC/browsecache.h \
+           $$PLUGIN_SRC/cometdscanner.h \
+           $$PLUGIN_SRC/jsonstreamreader.h \
+           $$PLUGIN_SRC/latencystats.h \
+           $$PLUGIN_SRC/libraryindex.h \
+           $$PLUGIN_SRC/linkdiagnostics.h \
+           $$PLUGIN_SRC/nowplayingmodel.h \
+           $$PLUGIN_SRC/placeholdertable.h \
+           $$PLUGIN_SRC/rttestimator.h \
+           $$PLUGIN_SRC/statusdecoder.h \
+           $$PLUGIN_SRC/thumbnailfetcher.h \
+           $$PLUGIN_SRC/thumbnailprovider.h \
+           $$PLUGIN_SRC/thumbnailstore.h \
+           driver.h \
+           fakes.h \
+           mocklms.h
+SOURCES += $$PLUGIN_SRC/squeezebox.cpp \
+           $$PLUGIN_SRC/browsecache.cpp \
+           $$PLUGIN_SRC/cometdscanner.cpp \
+           $$PLUGIN_SRC/jsonstreamreader.cpp \
+           $$PLUGIN_SRC/latencystats.cpp \
+           $$PLUGIN_SRC/libraryindex.cpp \
+           $$PLUGIN_SRC/linkdiagnostics.cpp \
+           $$PLUGIN_SRC/nowplayingmodel.cpp \
+           $$PLUGIN_SRC/placeholdertable.cpp \
+           $$PLUGIN_SRC/rttestimator.cpp \
+           $$PLUGIN_SRC/statusdecoder.cpp \
+           $$PLUGIN_SRC/thumbnailfetcher.cpp \
+           $$PLUGIN_SRC/thumbnailprovider.cpp \
+           $$PLUGIN_SRC/thumbnailstore.cpp \
+           driver.cpp \
+           fakes.cpp \
+           main.cpp \
+           mocklms.cpp
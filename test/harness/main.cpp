@@ -0,0 +1,145 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QTextStream>
+
+#include "driver.h"
+#include "mocklms.h"
+
+// sqharness connect [--mock N | --host H --port P] [--seconds S] [--latency MS]
+// sqharness soak --mock N [--hours H] [--interval MIN] [--max-rss-growth KB] [--max-object-growth N] [--max-drift MS]
+// sqharness latency --mock N [--latency MS] [--iterations N]
+// sqharness scale [--players 10,100,500] [--seconds S] [--push-interval MS]
+// sqharness serve --mock N [--port P]: only the mock server, e.g. for the app on a desktop
+// --record DIR writes the traffic of the mock server into DIR, the corpus of the fuzz targets in test/fuzz
+// Prints the report as JSON on stdout, the exit code is 1 when the run failed.
+
+namespace {
+
+int serve(const Driver::Options& options) {
+    MockLms mock;
+    mock.setLatency(options.latency);
+    mock.setTimeScale(options.mockTimeScale);
+    mock.setPushInterval(options.pushInterval);
+    mock.setRecordDirectory(options.recordDirectory);
+    mock.addPlayers(qMax(1, options.mockPlayers));
+    if (!mock.listen(options.port)) {
+        return 1;
+    }
+
+    // the scale run reads the port from the first line
+    QTextStream(stdout) << "port " << mock.port() << endl;
+    return QCoreApplication::exec();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("sqharness");
+
+    // the caches of the integration go to a test location, not to the ones of the app
+    QStandardPaths::setTestModeEnabled(true);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless driver of the Squeezebox integration");
+    parser.addHelpOption();
+    parser.addPositionalArgument("mode", "connect, soak, latency, scale or serve");
+    parser.addOption({"host", "Logitech Media Server to connect to.", "host", "127.0.0.1"});
+    parser.addOption({"port", "HTTP port of the server.", "port", "9000"});
+    parser.addOption({"mock", "Run against an in-process mock server with this many players.", "players", "0"});
+    parser.addOption({"seconds", "Seconds observed after the connection is up.", "seconds", "10"});
+    parser.addOption({"latency", "One way latency of the mock server in ms.", "ms", "0"});
+    parser.addOption({"mock-time-scale", "Speed of the mock clock, the integration runs in real time.", "factor", "1"});
+    parser.addOption({"hours", "Soak: duration on the wall clock.", "hours", "24"});
+    parser.addOption({"interval", "Soak: minutes between the events and samples.", "minutes", "60"});
+    parser.addOption({"max-rss-growth", "Soak: RSS growth which fails the run.", "KB", "8192"});
+    parser.addOption({"max-object-growth", "Soak: growth of the live objects which fails the run.", "count", "50"});
+    parser.addOption({"max-drift", "Soak: position drift which fails the run, in real time.", "ms", "500"});
+    parser.addOption({"iterations", "Latency: rounds of pause, play, volume and next per transport.", "count", "50"});
+    parser.addOption({"players", "Scale: player counts of the runs.", "list", "10,100,500"});
+    parser.addOption({"push-interval", "Status push of the playing mock players without a change.", "ms", "60000"});
+    parser.addOption({"record", "Write the traffic of the mock server as corpus of the fuzz targets.", "directory"});
+    parser.process(app);
+
+    Driver::Options options;
+    options.host = parser.value("host");
+    options.port = static_cast<quint16>(parser.value("port").toUInt());
+    options.mockPlayers = parser.value("mock").toInt();
+    options.seconds = parser.value("seconds").toInt();
+    options.latency = parser.value("latency").toInt();
+    options.hours = parser.value("hours").toDouble();
+    options.intervalMinutes = parser.value("interval").toInt();
+    options.maxRssGrowthKb = parser.value("max-rss-growth").toInt();
+    options.maxObjectGrowth = parser.value("max-object-growth").toInt();
+    options.maxDriftMs = parser.value("max-drift").toInt();
+    options.iterations = parser.value("iterations").toInt();
+    options.pushInterval = parser.value("push-interval").toInt();
+    options.recordDirectory = parser.value("record");
+
+    QString mode = parser.positionalArguments().value(0, "connect");
+
+    options.mockTimeScale = parser.value("mock-time-scale").toDouble();
+    if (options.mockTimeScale <= 0) {
+        options.mockTimeScale = 1;
+    }
+
+    if (mode == "serve") {
+        return serve(options);
+    }
+
+    QVariantMap report;
+    bool        failed = false;
+    if (mode == "scale") {
+        // a driver per run, the integration and its entities start from scratch
+        QVariantList runs;
+        for (const QString& players : parser.value("players").split(',')) {
+            Driver::Options run = options;
+            run.mockPlayers = players.toInt();
+            Driver driver(run);
+            runs.append(driver.scaleRun());
+            failed |= driver.failed();
+        }
+        report.insert("mode", "scale");
+        report.insert("runs", runs);
+    } else {
+        Driver driver(options);
+        if (mode == "connect") {
+            report = driver.connectRun();
+        } else if (mode == "soak") {
+            report = driver.soakRun();
+        } else if (mode == "latency") {
+            report = driver.latencyRun();
+        } else {
+            parser.showHelp(2);
+        }
+        failed = driver.failed();
+    }
+
+    QTextStream(stdout) << QJsonDocument(QJsonObject::fromVariantMap(report)).toJson();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,532 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "mocklms.h"
+
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonValue>
+#include <QVariantList>
+#include <cmath>
+
+MockLms::MockLms(QObject* parent)
+    : QObject(parent),
+      _virtualBase(0),
+      _realBase(0),
+      _timeScale(1.0),
+      _latency(0),
+      _trackSeconds(240),
+      _pushInterval(60 * 1000),
+      _libraryTracks(1000),
+      _clients(0),
+      _rpcRequests(0),
+      _cometdMessages(0),
+      _pushes(0),
+      _bytesSent(0),
+      _records(0) {
+    _realTime.start();
+    QObject::connect(&_server, &QTcpServer::newConnection, this, &MockLms::accepted);
+
+    _flush.setSingleShot(true);
+    QObject::connect(&_flush, &QTimer::timeout, this, &MockLms::flushCometd);
+
+    // track ends and the periodic status of the subscriptions
+    _ticker.setInterval(100);
+    QObject::connect(&_ticker, &QTimer::timeout, this, &MockLms::tick);
+    _ticker.start();
+}
+
+bool MockLms::listen(quint16 port) { return _server.listen(QHostAddress::LocalHost, port); }
+
+void MockLms::addPlayers(int count) {
+    for (int i = 0; i < count; ++i) {
+        int    number = _order.size() + 1;
+        Player player;
+        player.mac = mac(number);
+        player.name = QStringLiteral("Player %1").arg(number);
+        player.track = number % player.tracks;
+        player.position = (number * 37) % _trackSeconds;  // not all tracks end at the same time
+        player.positionTime = now();
+        player.playlistTimestamp = 1600000000.0 + number;
+        _players.insert(player.mac, player);
+        _order.append(player.mac);
+    }
+}
+
+QString MockLms::mac(int number) {
+    return QStringLiteral("00:04:20:%1:%2:%3")
+        .arg((number >> 16) & 0xff, 2, 16, QChar('0'))
+        .arg((number >> 8) & 0xff, 2, 16, QChar('0'))
+        .arg(number & 0xff, 2, 16, QChar('0'));
+}
+
+void MockLms::setTimeScale(double scale) {
+    // the virtual clock continues from where it is
+    _virtualBase = now();
+    _realBase = _realTime.elapsed();
+    _timeScale = scale;
+}
+
+qint64 MockLms::now() const {
+    return _virtualBase + static_cast<qint64>((_realTime.elapsed() - _realBase) * _timeScale);
+}
+
+double MockLms::position(const QString& mac) const {
+    auto player = _players.constFind(mac);
+    if (player == _players.constEnd()) {
+        return 0;
+    }
+    if (player->mode != "play" || !player->power) {
+        return player->position;
+    }
+    // the track may have ended since the last tick, the next one starts from 0 like in advance()
+    return std::fmod(player->position + (now() - player->positionTime) / 1000.0, _trackSeconds);
+}
+
+bool MockLms::isPlaying(const QString& mac) const {
+    auto player = _players.constFind(mac);
+    return player != _players.constEnd() && player->power && player->mode == "play";
+}
+
+int MockLms::subscriptions() const {
+    int count = 0;
+    for (const Player& player : _players) {
+        if (!player.subscriber.isNull()) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void MockLms::command(const QString& mac, const QStringList& command) { execute(mac, command); }
+
+void MockLms::dropConnections() {
+    _pending.clear();
+    for (QTcpSocket* socket : _connections.keys()) {
+        socket->abort();
+    }
+}
+
+void MockLms::accepted() {
+    while (_server.hasPendingConnections()) {
+        QTcpSocket* socket = _server.nextPendingConnection();
+        _connections.insert(socket, Connection());
+        QObject::connect(socket, &QTcpSocket::readyRead, this, [=]() { received(socket); });
+        QObject::connect(socket, &QTcpSocket::disconnected, this, [=]() {
+            _connections.remove(socket);
+            _pending.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void MockLms::received(QTcpSocket* socket) {
+    Connection& connection = _connections[socket];
+    connection.buffer += socket->readAll();
+
+    forever {
+        // the plugin ends every CometD request with a newline which is not part of the content
+        while (connection.buffer.startsWith('\n') || connection.buffer.startsWith('\r')) {
+            connection.buffer.remove(0, 1);
+        }
+
+        // QNetworkAccessManager ends the header lines with CRLF, the CometD requests of the plugin with LF only
+        int headerEnd = connection.buffer.indexOf("\r\n\r\n");
+        int separator = 4;
+        int lfEnd = connection.buffer.indexOf("\n\n");
+        if (lfEnd >= 0 && (headerEnd < 0 || lfEnd < headerEnd)) {
+            headerEnd = lfEnd;
+            separator = 2;
+        }
+        if (headerEnd < 0) {
+            return;
+        }
+
+        QList<QByteArray> lines = connection.buffer.left(headerEnd).split('\n');
+        int               length = 0;
+        for (const QByteArray& line : lines.mid(1)) {
+            if (line.trimmed().toLower().startsWith("content-length:")) {
+                length = line.trimmed().mid(15).trimmed().toInt();
+            }
+        }
+        if (connection.buffer.size() < headerEnd + separator + length) {
+            return;
+        }
+
+        QByteArray path = lines.first().trimmed().split(' ').value(1);
+        QByteArray body = connection.buffer.mid(headerEnd + separator, length);
+        connection.buffer.remove(0, headerEnd + separator + length);
+
+        if (_latency <= 0) {
+            request(socket, path, body);
+        } else {
+            QPointer<QTcpSocket> target(socket);
+            QTimer::singleShot(_latency, this, [=]() {
+                if (!target.isNull()) {
+                    request(target, path, body);
+                }
+            });
+        }
+    }
+}
+
+void MockLms::request(QTcpSocket* socket, const QByteArray& path, const QByteArray& body) {
+    if (path.startsWith("/jsonrpc.js")) {
+        rpc(socket, body);
+    } else if (path.startsWith("/cometd")) {
+        cometd(socket, body);
+    } else {
+        // cover art and icons are not served
+        send(socket, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+    }
+}
+
+void MockLms::rpc(QTcpSocket* socket, const QByteArray& body) {
+    _rpcRequests++;
+
+    QJsonObject json = QJsonDocument::fromJson(body).object();
+    QJsonArray  params = json.value("params").toArray();
+    QStringList command;
+    for (const QJsonValue& word : params.at(1).toArray()) {
+        command.append(word.toVariant().toString());
+    }
+    json.insert("result", QJsonObject::fromVariantMap(execute(params.at(0).toString(), command)));
+
+    QByteArray data = QJsonDocument(json).toJson(QJsonDocument::Compact);
+    record("jsonstreamreader", data);
+    send(socket, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+                     QByteArray::number(data.size()) + "\r\n\r\n" + data);
+}
+
+void MockLms::cometd(QTcpSocket* socket, const QByteArray& body) {
+    for (const QJsonValue& value : QJsonDocument::fromJson(body).array()) {
+        _cometdMessages++;
+        QJsonObject message = value.toObject();
+        QString     channel = message.value("channel").toString();
+        QJsonObject data = message.value("data").toObject();
+        QJsonObject reply;
+        reply.insert("channel", channel);
+        reply.insert("successful", true);
+        if (message.contains("id")) {
+            reply.insert("id", message.value("id"));
+        }
+
+        if (channel == "/meta/handshake") {
+            reply.insert("clientId", QString::number(0x5a000000 + ++_clients, 16));
+            reply.insert("version", "1.0");
+            reply.insert("supportedConnectionTypes", QJsonArray({"long-polling", "streaming"}));
+            queueCometd(socket, reply);
+        } else if (channel == "/meta/connect") {
+            reply.insert("clientId", message.value("clientId"));
+            queueCometd(socket, reply);
+        } else if (channel == "/slim/subscribe") {
+            QString mac = data.value("request").toArray().at(0).toString();
+            auto    player = _players.find(mac);
+            reply.insert("successful", player != _players.end());
+            queueCometd(socket, reply);
+
+            // the current status goes out right away, like on the real server
+            if (player != _players.end()) {
+                player->subscriber = socket;
+                player->response = data.value("response").toString();
+                player->subscriptionId = message.value("id");
+                push(&*player);
+            }
+        } else if (channel == "/slim/unsubscribe") {
+            QString response = data.value("unsubscribe").toString();
+            for (Player& player : _players) {
+                if (player.subscriber == socket && player.response == response) {
+                    player.subscriber.clear();
+                    player.response.clear();
+                }
+            }
+            queueCometd(socket, reply);
+        } else if (channel == "/slim/request") {
+            QJsonArray  request = data.value("request").toArray();
+            QStringList command;
+            for (const QJsonValue& word : request.at(1).toArray()) {
+                command.append(word.toVariant().toString());
+            }
+            QVariantMap result = execute(request.at(0).toString(), command);
+            queueCometd(socket, reply);
+
+            if (data.contains("response")) {
+                QJsonObject response;
+                response.insert("channel", data.value("response"));
+                response.insert("id", message.value("id"));
+                response.insert("data", QJsonObject::fromVariantMap(result));
+                queueCometd(socket, response);
+            }
+        } else {
+            reply.insert("successful", false);
+            reply.insert("error", "402::Unknown channel");
+            queueCometd(socket, reply);
+        }
+    }
+}
+
+void MockLms::send(QTcpSocket* socket, const QByteArray& data) {
+    _bytesSent += data.size();
+    if (_latency <= 0) {
+        socket->write(data);
+        return;
+    }
+
+    QPointer<QTcpSocket> target(socket);
+    QTimer::singleShot(_latency, this, [=]() {
+        if (!target.isNull()) {
+            target->write(data);
+        }
+    });
+}
+
+void MockLms::queueCometd(QTcpSocket* socket, const QJsonObject& message) {
+    Outgoing outgoing;
+    outgoing.due = _realTime.elapsed() + _latency;
+    outgoing.message = message;
+    _pending[socket].append(outgoing);
+    if (!_flush.isActive()) {
+        _flush.start(_latency);
+    }
+}
+
+void MockLms::flushCometd() {
+    // everything due goes out as one chunk, the plugin expects one chunk per read
+    qint64 now = _realTime.elapsed();
+    qint64 next = -1;
+    for (auto i = _pending.begin(); i != _pending.end(); ++i) {
+        QJsonArray messages;
+        while (!i->isEmpty() && i->first().due <= now) {
+            messages.append(i->takeFirst().message);
+        }
+        if (!i->isEmpty() && (next < 0 || i->first().due < next)) {
+            next = i->first().due;
+        }
+        if (messages.isEmpty() || !_connections.contains(i.key())) {
+            continue;
+        }
+
+        QByteArray json = QJsonDocument(messages).toJson(QJsonDocument::Compact);
+        QByteArray chunk = QByteArray::number(json.size(), 16) + "\r\n" + json + "\r\n";
+        Connection& connection = _connections[i.key()];
+        if (!connection.streaming) {
+            connection.streaming = true;
+            chunk.prepend("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n");
+        }
+        record("cometdscanner", json);
+        record("statusdecoder", chunk);
+        _bytesSent += chunk.size();
+        i.key()->write(chunk);
+    }
+    if (next >= 0) {
+        _flush.start(static_cast<int>(qMax<qint64>(0, next - now)));
+    }
+}
+
+void MockLms::tick() {
+    qint64 now = _realTime.elapsed();
+    for (Player& player : _players) {
+        if (advance(&player) || (player.power && player.mode == "play" && now - player.lastPush >= _pushInterval)) {
+            push(&player);
+        }
+    }
+}
+
+QVariantMap MockLms::execute(const QString& mac, const QStringList& command) {
+    QVariantMap result;
+    QString     name = command.value(0);
+
+    if (name == "players") {
+        QVariantList loop;
+        for (int i = command.value(1).toInt(); i < _order.size() && loop.size() < command.value(2).toInt(); ++i) {
+            const Player& player = _players[_order.at(i)];
+            QVariantMap   item;
+            item.insert("playerid", player.mac);
+            item.insert("name", player.name);
+            item.insert("model", "squeezelite");
+            item.insert("isplayer", 1);
+            item.insert("connected", 1);
+            item.insert("canpoweroff", 1);
+            item.insert("power", player.power ? 1 : 0);
+            loop.append(item);
+        }
+        result.insert("count", _order.size());
+        result.insert("players_loop", loop);
+        return result;
+    }
+    if (name == "serverstatus") {
+        result.insert("lastscan", "1600000000");
+        result.insert("version", "8.0.0");
+        result.insert("player count", _order.size());
+        return result;
+    }
+    if (name == "titles") {
+        QVariantList loop;
+        int          start = command.value(1).toInt();
+        for (int i = start; i < _libraryTracks && i - start < command.value(2).toInt(); ++i) {
+            QVariantMap item;
+            item.insert("id", 100000 + i);
+            item.insert("title", QStringLiteral("Track %1").arg(i));
+            item.insert("artist", QStringLiteral("Artist %1").arg(i % 97));
+            item.insert("artist_id", i % 97);
+            item.insert("album", QStringLiteral("Album %1").arg(i % 389));
+            item.insert("album_id", i % 389);
+            loop.append(item);
+        }
+        result.insert("count", _libraryTracks);
+        result.insert("titles_loop", loop);
+        return result;
+    }
+    if (name == "version") {
+        result.insert("_version", "8.0.0");
+        return result;
+    }
+
+    auto found = _players.find(mac);
+    if (found == _players.end()) {
+        return result;
+    }
+    Player& player = *found;
+    if (name == "status") {
+        return status(player, command);
+    }
+    emit commandReceived(mac, command);
+
+    // the position is brought up to date before anything changes
+    advance(&player);
+    QString argument = command.value(command.size() - 1);
+    bool    relative = argument.startsWith('+') || argument.startsWith('-');
+    if (name == "play") {
+        player.mode = "play";
+        player.power = true;
+    } else if (name == "pause") {
+        bool pause = command.size() > 1 ? argument == "1" : player.mode == "play";
+        player.mode = pause ? "pause" : "play";
+    } else if (name == "stop") {
+        player.mode = "stop";
+    } else if (name == "power") {
+        player.power = argument == "1";
+    } else if (name == "mixer" && command.value(1) == "volume") {
+        player.volume = qBound(0, relative ? player.volume + argument.toInt() : argument.toInt(), 100);
+    } else if (name == "mixer" && command.value(1) == "muting") {
+        player.muted = command.size() > 2 ? argument == "1" : !player.muted;
+    } else if (name == "button" && (argument == "volume_up" || argument == "volume_down")) {
+        player.volume = qBound(0, player.volume + (argument == "volume_up" ? 5 : -5), 100);
+    } else if (name == "playlist" && (command.value(1) == "jump" || command.value(1) == "index")) {
+        int track = relative ? player.track + argument.toInt() : argument.toInt();
+        player.track = ((track % player.tracks) + player.tracks) % player.tracks;
+        player.position = 0;
+    } else if (name == "time") {
+        player.position = qBound(0.0, relative ? player.position + argument.toDouble() : argument.toDouble(),
+                                 static_cast<double>(_trackSeconds));
+    } else {
+        return result;
+    }
+    push(&player);
+    return result;
+}
+
+QVariantMap MockLms::status(const Player& player, const QStringList& command) const {
+    QVariantMap result;
+    result.insert("player_name", player.name);
+    result.insert("player_connected", 1);
+    result.insert("power", player.power ? 1 : 0);
+    result.insert("mode", player.mode);
+    result.insert("time", position(player.mac));
+    result.insert("rate", _timeScale);  // the virtual clock runs faster than the real one
+    result.insert("duration", _trackSeconds);
+    result.insert("mixer volume", player.muted ? -player.volume : player.volume);
+    result.insert("playlist_cur_index", QString::number(player.track));
+    result.insert("playlist_timestamp", player.playlistTimestamp);
+    result.insert("playlist_tracks", player.tracks);
+
+    // "status - 1" is the current track, "status <start> <count>" a window of the playlist
+    QVariantList loop;
+    bool         current = command.value(1) == "-";
+    int          start = current ? player.track : command.value(1).toInt();
+    int          count = current ? 1 : command.value(2).toInt();
+    for (int i = qMax(0, start); i < player.tracks && i < start + count; ++i) {
+        loop.append(trackItem(player, i));
+    }
+    result.insert("playlist_loop", loop);
+    return result;
+}
+
+QVariantMap MockLms::trackItem(const Player& player, int index) const {
+    int         id = 100000 + (player.tracks * _order.indexOf(player.mac) + index) % qMax(1, _libraryTracks);
+    QVariantMap item;
+    item.insert("playlist index", index);
+    item.insert("id", id);
+    item.insert("title", QStringLiteral("Track %1").arg(id - 100000));
+    item.insert("artist", QStringLiteral("Artist %1").arg((id - 100000) % 97));
+    item.insert("coverid", QString::number(id, 16));
+    item.insert("coverart", "1");
+    item.insert("duration", _trackSeconds);
+    return item;
+}
+
+bool MockLms::advance(Player* player) {
+    qint64 now = this->now();
+    bool   changed = false;
+    if (player->power && player->mode == "play") {
+        player->position += (now - player->positionTime) / 1000.0;
+        while (player->position >= _trackSeconds) {
+            player->position -= _trackSeconds;
+            player->track = (player->track + 1) % player->tracks;
+            changed = true;
+        }
+    }
+    player->positionTime = now;
+    return changed;
+}
+
+void MockLms::push(Player* player) {
+    if (player->subscriber.isNull()) {
+        return;
+    }
+
+    QJsonObject message;
+    message.insert("channel", player->response);
+    message.insert("id", player->subscriptionId);
+    message.insert("data", QJsonObject::fromVariantMap(status(*player, {"status", "-", "1"})));
+    queueCometd(player->subscriber, message);
+    player->lastPush = _realTime.elapsed();
+    _pushes++;
+}
+
+void MockLms::record(const QString& target, const QByteArray& data) {
+    if (_recordDirectory.isEmpty()) {
+        return;
+    }
+
+    // numbered, so a directory listing keeps the order of the session
+    QDir directory(_recordDirectory + "/" + target);
+    if (!directory.mkpath(".")) {
+        return;
+    }
+    QString suffix = target == "statusdecoder" ? "http" : "json";
+    QFile   file(directory.filePath(QString("%1.%2").arg(++_records, 6, 10, QChar('0')).arg(suffix)));
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(data);
+    }
+}
@@ -0,0 +1,151 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Andreas Mroß <andreas@mross.pw>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QStringList>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QVariantMap>
+
+// Stand-in of a Logitech Media Server: JSON-RPC over HTTP and the CometD streaming connection on one port, like
+// the real server. Its virtual players play through their playlists, follow the commands and push their status to
+// the subscriptions. The players run on a virtual clock which can run faster than the real one, and every reply
+// and push can be delayed to simulate a slow link.
+class MockLms : public QObject {
+    Q_OBJECT
+
+ public:
+    explicit MockLms(QObject* parent = nullptr);
+
+    bool    listen(quint16 port = 0);  // any free port by default
+    quint16 port() const { return _server.serverPort(); }
+
+    void           addPlayers(int count);
+    QStringList    players() const { return _order; }
+    static QString mac(int number);  // of the player with the number, counted from 1
+
+    void setLatency(int msecs) { _latency = msecs; }                // one way, replies and pushes
+    void setTimeScale(double scale);                                // virtual seconds per real second
+    void setTrackSeconds(int seconds) { _trackSeconds = seconds; }  // of every track
+    int  trackSeconds() const { return _trackSeconds; }
+    void setPushInterval(int msecs) { _pushInterval = msecs; }  // status of playing players without a change
+    void setLibraryTracks(int tracks) { _libraryTracks = tracks; }
+
+    // every socket read, CometD batch and RPC reply is written to a subdirectory per fuzz target of test/fuzz
+    void setRecordDirectory(const QString& directory) { _recordDirectory = directory; }
+
+    qint64 now() const;                         // virtual msecs
+    double position(const QString& mac) const;  // true position in virtual seconds
+    bool   isPlaying(const QString& mac) const;
+    int    subscriptions() const;
+
+    // a command as if it came from another controller, the status is pushed to the subscriptions
+    void command(const QString& mac, const QStringList& command);
+
+    // server restart or lost link: all connections are closed, the players keep playing
+    void dropConnections();
+
+    int    rpcRequests() const { return _rpcRequests; }
+    int    cometdMessages() const { return _cometdMessages; }
+    int    pushes() const { return _pushes; }
+    qint64 bytesSent() const { return _bytesSent; }
+    int    connections() const { return _connections.size(); }
+
+ signals:
+    void commandReceived(const QString& mac, const QStringList& command);  // before it is executed, not for queries
+
+ private:
+    struct Player {
+        QString              mac;
+        QString              name;
+        bool                 power = true;
+        QString              mode = "play";
+        int                  volume = 50;
+        bool                 muted = false;
+        int                  track = 0;  // playlist index
+        int                  tracks = 20;
+        double               position = 0;      // seconds at positionTime
+        qint64               positionTime = 0;  // virtual msecs
+        double               playlistTimestamp = 0;
+        qint64               lastPush = 0;  // real msecs
+        QPointer<QTcpSocket> subscriber;
+        QString              response;  // channel of the subscription
+        QJsonValue           subscriptionId;
+    };
+    struct Connection {
+        QByteArray buffer;
+        bool       streaming = false;  // CometD response headers sent
+    };
+    struct Outgoing {
+        qint64      due = 0;  // real msecs
+        QJsonObject message;
+    };
+
+    void        accepted();
+    void        received(QTcpSocket* socket);
+    void        request(QTcpSocket* socket, const QByteArray& path, const QByteArray& body);
+    void        rpc(QTcpSocket* socket, const QByteArray& body);
+    void        cometd(QTcpSocket* socket, const QByteArray& body);
+    void        send(QTcpSocket* socket, const QByteArray& data);
+    void        queueCometd(QTcpSocket* socket, const QJsonObject& message);
+    void        flushCometd();
+    void        tick();
+    QVariantMap execute(const QString& mac, const QStringList& command);
+    QVariantMap status(const Player& player, const QStringList& command) const;
+    QVariantMap trackItem(const Player& player, int index) const;
+    bool        advance(Player* player);  // true on a track change
+    void        push(Player* player);
+    void        record(const QString& target, const QByteArray& data);
+
+    QTcpServer                          _server;
+    QHash<QTcpSocket*, Connection>      _connections;
+    QHash<QString, Player>              _players;  // key: mac
+    QStringList                         _order;
+    QHash<QTcpSocket*, QList<Outgoing>> _pending;  // CometD messages, all due ones go out in one chunk
+    QTimer                              _flush;
+    QTimer                              _ticker;
+    QElapsedTimer                       _realTime;
+    qint64                              _virtualBase;  // virtual msecs at the last time scale change
+    qint64                              _realBase;
+    double                              _timeScale;
+    int                                 _latency;
+    int                                 _trackSeconds;
+    int                                 _pushInterval;
+    int                                 _libraryTracks;
+    int                                 _clients;
+    int                                 _rpcRequests;
+    int                                 _cometdMessages;
+    int                                 _pushes;
+    qint64                              _bytesSent;
+    QString                             _recordDirectory;
+    int                                 _records;
+};
@@ -0,0 +1,6 @@
+# Benchmarks and test drivers of the Squeezebox integration, built separately from the plugin:
+#   qmake test/test.pro && make
+TEMPLATE = subdirs
+SUBDIRS  = harness \
+           cometdbench \
+           fuzz